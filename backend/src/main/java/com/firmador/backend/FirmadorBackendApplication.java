@@ -3,12 +3,14 @@ package com.firmador.backend;
 import org.springframework.boot.SpringApplication;
 import org.springframework.boot.autoconfigure.SpringBootApplication;
 import org.springframework.context.annotation.Bean;
+import org.springframework.scheduling.annotation.EnableScheduling;
 import org.springframework.web.multipart.MultipartResolver;
 import org.springframework.web.multipart.support.StandardServletMultipartResolver;
 import org.springframework.web.servlet.config.annotation.CorsRegistry;
 import org.springframework.web.servlet.config.annotation.WebMvcConfigurer;
 
 @SpringBootApplication
+@EnableScheduling
 public class FirmadorBackendApplication {
 
     public static void main(String[] args) {
@@ -29,6 +31,9 @@ public class FirmadorBackendApplication {
                         .allowedOrigins("*")
                         .allowedMethods("GET", "POST", "PUT", "DELETE", "OPTIONS")
                         .allowedHeaders("*")
+                        .exposedHeaders("Content-Disposition", "X-Document-Id",
+                                "X-Compaction-Original-Size", "X-Compaction-Compacted-Size",
+                                "X-Compaction-Deduplicated-Streams", "X-Compaction-Millis")
                         .maxAge(3600);
             }
         };
@@ -1,14 +1,23 @@
 package com.firmador.backend.controller;
 
 import com.firmador.backend.dto.CertificateInfo;
+import com.firmador.backend.dto.PreflightResult;
 import com.firmador.backend.dto.SignatureRequest;
 import com.firmador.backend.dto.SignatureResponse;
+import com.firmador.backend.service.BatchTimestampService;
 import com.firmador.backend.service.DigitalSignatureService;
 import com.firmador.backend.service.DocumentStorageService;
+import com.firmador.backend.service.PdfCompactionService;
+import com.firmador.backend.service.PdfPreflightService;
+import com.firmador.backend.service.SigningJobQueue;
+import com.firmador.backend.service.StreamingSignatureService;
+import jakarta.servlet.http.HttpServletRequest;
+import jakarta.servlet.http.HttpServletResponse;
 import jakarta.validation.Valid;
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.core.io.FileSystemResource;
 import org.springframework.http.HttpHeaders;
 import org.springframework.http.HttpStatus;
 import org.springframework.http.MediaType;
@@ -16,8 +25,13 @@ import org.springframework.http.ResponseEntity;
 import org.springframework.web.bind.annotation.*;
 import org.springframework.web.multipart.MultipartFile;
 
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
 import java.util.HashMap;
 import java.util.Map;
+import java.util.Optional;
+import java.util.UUID;
 
 @RestController
 @RequestMapping("/api/signature")
@@ -29,11 +43,26 @@ public class DigitalSignatureController {
     @Autowired
     private DigitalSignatureService digitalSignatureService;
     private final DocumentStorageService documentStorageService;
+    private final PdfPreflightService pdfPreflightService;
+    private final SigningJobQueue signingJobQueue;
+    private final PdfCompactionService pdfCompactionService;
+    private final StreamingSignatureService streamingSignatureService;
+    private final BatchTimestampService batchTimestampService;
 
     public DigitalSignatureController(DigitalSignatureService digitalSignatureService,
-                                    DocumentStorageService documentStorageService) {
+                                    DocumentStorageService documentStorageService,
+                                    PdfPreflightService pdfPreflightService,
+                                    SigningJobQueue signingJobQueue,
+                                    PdfCompactionService pdfCompactionService,
+                                    StreamingSignatureService streamingSignatureService,
+                                    BatchTimestampService batchTimestampService) {
         this.digitalSignatureService = digitalSignatureService;
         this.documentStorageService = documentStorageService;
+        this.pdfPreflightService = pdfPreflightService;
+        this.signingJobQueue = signingJobQueue;
+        this.pdfCompactionService = pdfCompactionService;
+        this.streamingSignatureService = streamingSignatureService;
+        this.batchTimestampService = batchTimestampService;
     }
 
     @PostMapping("/sign")
@@ -51,7 +80,10 @@ public class DigitalSignatureController {
             @RequestParam(value = "signatureHeight", defaultValue = "50.0") Double signatureHeight,
             @RequestParam(value = "signaturePage", defaultValue = "1") Integer signaturePage,
             @RequestParam(value = "enableTimestamp", defaultValue = "false") Boolean enableTimestamp,
-            @RequestParam(value = "timestampServerUrl", defaultValue = "https://freetsa.org/tsr") String timestampServerUrl) {
+            @RequestParam(value = "timestampServerUrl", defaultValue = "https://freetsa.org/tsr") String timestampServerUrl,
+            @RequestParam(value = "async", defaultValue = "false") Boolean async,
+            @RequestParam(value = "compact", defaultValue = "false") Boolean compact,
+            @RequestParam(value = "batchTimestamp", defaultValue = "false") Boolean batchTimestamp) {
         
         try {
             // Validation
@@ -65,6 +97,11 @@ public class DigitalSignatureController {
                     .body(Map.of("error", "Certificate file is required"));
             }
             
+            if (!isPdfFile(file)) {
+                return ResponseEntity.badRequest()
+                    .body(Map.of("error", "File must be a PDF document"));
+            }
+            
             // Create signature request
             SignatureRequest request = new SignatureRequest();
             request.setSignerName(signerName);
@@ -80,9 +117,7 @@ public class DigitalSignatureController {
             request.setSignaturePage(signaturePage);
             request.setEnableTimestamp(enableTimestamp);
             request.setTimestampServerUrl(timestampServerUrl);
-            
-            // Sign the document
-            byte[] signedPdf = digitalSignatureService.signPdf(file.getBytes(), request);
+            request.setBatchTimestamp(batchTimestamp);
             
             // Generate response filename
             String originalFilename = file.getOriginalFilename();
@@ -90,8 +125,71 @@ public class DigitalSignatureController {
                 originalFilename.replaceFirst("(\\.[^.]*)?$", "_signed$1") :
                 "signed_document.pdf";
             
+            // Large uploads are signed from disk; compaction and the cluster
+            // queue still need the whole document in memory
+            if (digitalSignatureService.isLargeDocument(file.getSize()) &&
+                    !Boolean.TRUE.equals(compact) && !Boolean.TRUE.equals(async)) {
+                return signLargeDocument(file, request, signedFilename);
+            }
+            
+            // Reject corrupt, truncated or encrypted input before loading the
+            // certificate and building the PDF object graph
+            byte[] pdfBytes = file.getBytes();
+            PreflightResult preflight = pdfPreflightService.scan(pdfBytes, signaturePage);
+            if (!preflight.isOk()) {
+                logger.warn("Preflight rejected {}: {}", file.getOriginalFilename(), preflight.getMessage());
+                return ResponseEntity.unprocessableEntity()
+                    .body(Map.of(
+                        "error", preflight.getMessage(),
+                        "code", preflight.getStatus().name(),
+                        "preflight", preflight));
+            }
+            
+            // Optional one-time rewrite to shrink bloated scans before signing
+            PdfCompactionService.CompactionResult compaction = null;
+            if (Boolean.TRUE.equals(compact)) {
+                if (preflight.isHasExistingSignatures()) {
+                    return compactionRefused();
+                }
+                try {
+                    compaction = pdfCompactionService.compact(pdfBytes);
+                } catch (PdfCompactionService.SignedDocumentException e) {
+                    return compactionRefused();
+                }
+                pdfBytes = compaction.getData();
+            }
+            
+            // In cluster mode the job goes to the shared queue and any instance may sign it
+            if (Boolean.TRUE.equals(async)) {
+                if (!signingJobQueue.isEnabled()) {
+                    return ResponseEntity.status(HttpStatus.SERVICE_UNAVAILABLE)
+                        .body(Map.of("error", "Cluster mode is disabled"));
+                }
+                String filename = file.getOriginalFilename() != null ? file.getOriginalFilename() : "document.pdf";
+                String jobId = signingJobQueue.submit(pdfBytes, filename, request);
+                return ResponseEntity.accepted()
+                    .headers(compactionHeaders(compaction))
+                    .body(Map.of(
+                        "jobId", jobId,
+                        "statusUrl", "/api/signature/jobs/" + jobId,
+                        "resultUrl", "/api/signature/jobs/" + jobId + "/result"));
+            }
+            
+            // Sign the document
+            byte[] signedPdf = digitalSignatureService.signPdf(pdfBytes, request);
+            
+            // Behind nginx the result is written to shared storage and nginx sends it
+            if (documentStorageService.isAccelRedirectEnabled()) {
+                String documentId = UUID.randomUUID().toString();
+                documentStorageService.storeDocument(documentId, signedPdf, signedFilename, MediaType.APPLICATION_PDF_VALUE);
+                HttpHeaders headers = compactionHeaders(compaction);
+                headers.add("X-Document-Id", documentId);
+                return fileResponse(documentStorageService.getDocument(documentId).getPath(), signedFilename, headers);
+            }
+            
             // Return signed PDF
             return ResponseEntity.ok()
+                .headers(compactionHeaders(compaction))
                 .header(HttpHeaders.CONTENT_DISPOSITION, "attachment; filename=\"" + signedFilename + "\"")
                 .header(HttpHeaders.CONTENT_TYPE, MediaType.APPLICATION_PDF_VALUE)
                 .body(signedPdf);
@@ -103,6 +201,65 @@ public class DigitalSignatureController {
         }
     }
 
+    /**
+     * Lazy path of {@code /sign}: the multipart spool file is moved into
+     * storage, preflighted through a mapped source and signed as an
+     * incremental update, and the result is served from disk.
+     */
+    private ResponseEntity<?> signLargeDocument(MultipartFile file, SignatureRequest request,
+                                                String signedFilename) throws IOException {
+        String documentId = UUID.randomUUID().toString();
+        Path input = documentStorageService.createStagingFile(documentId);
+        Path output = documentStorageService.createStagingFile(documentId);
+        try {
+            // The File overload lets Tomcat rename its spool file instead of copying
+            file.transferTo(input.toAbsolutePath().toFile());
+            PreflightResult preflight = pdfPreflightService.scan(input, request.getSignaturePage());
+            if (!preflight.isOk()) {
+                logger.warn("Preflight rejected {}: {}", file.getOriginalFilename(), preflight.getMessage());
+                return ResponseEntity.unprocessableEntity()
+                    .body(Map.of(
+                        "error", preflight.getMessage(),
+                        "code", preflight.getStatus().name(),
+                        "preflight", preflight));
+            }
+            
+            digitalSignatureService.signPdf(input, output, request);
+            documentStorageService.storeDocument(documentId, output, signedFilename);
+            
+            HttpHeaders headers = new HttpHeaders();
+            headers.add("X-Document-Id", documentId);
+            return fileResponse(documentStorageService.getDocument(documentId).getPath(), signedFilename, headers);
+        } finally {
+            Files.deleteIfExists(input);
+            Files.deleteIfExists(output);
+        }
+    }
+
+    /**
+     * Framed binary variant of {@code /sign}; see {@link StreamingSignatureService}
+     * for the wire format. The body is read directly from the request stream,
+     * without multipart parsing or temp-file spooling.
+     */
+    @PostMapping(value = "/sign-stream", consumes = StreamingSignatureService.CONTENT_TYPE)
+    public void signDocumentStream(HttpServletRequest request, HttpServletResponse response) throws IOException {
+        response.setContentType(StreamingSignatureService.CONTENT_TYPE);
+        try {
+            streamingSignatureService.sign(request.getInputStream(), response.getOutputStream());
+        } catch (StreamingSignatureService.StreamSignException e) {
+            logger.warn("Rejected streamed signature request: {} ({})", e.getMessage(), e.getCode());
+            response.setStatus(e.getStatus());
+            streamingSignatureService.writeError(response.getOutputStream(), e);
+        } catch (RuntimeException e) {
+            logger.error("Error during streamed document signing", e);
+            response.setStatus(HttpStatus.INTERNAL_SERVER_ERROR.value());
+            streamingSignatureService.writeError(response.getOutputStream(),
+                new StreamingSignatureService.StreamSignException(
+                    HttpStatus.INTERNAL_SERVER_ERROR.value(), "SIGNING_FAILED",
+                    "Failed to sign document: " + e.getMessage()));
+        }
+    }
+
     @PostMapping(value = "/validate-certificate", consumes = MediaType.MULTIPART_FORM_DATA_VALUE)
     public ResponseEntity<Map<String, Object>> validateCertificate(
             @RequestParam("certificate") MultipartFile certificate,
@@ -132,6 +289,37 @@ public class DigitalSignatureController {
         }
     }
 
+    @PostMapping(value = "/verify-evidence", consumes = MediaType.MULTIPART_FORM_DATA_VALUE)
+    public ResponseEntity<Map<String, Object>> verifyEvidenceRecord(@RequestParam("file") MultipartFile file) {
+
+        Map<String, Object> response = new HashMap<>();
+
+        try {
+            if (!isPdfFile(file)) {
+                response.put("verified", false);
+                response.put("message", "Only PDF files are supported");
+                return ResponseEntity.badRequest().body(response);
+            }
+
+            BatchTimestampService.Verification verification = batchTimestampService.verifyDocument(file.getBytes());
+
+            response.put("verified", verification.isValid());
+            response.put("message", verification.getMessage());
+            if (verification.isValid()) {
+                response.put("tsaSubject", verification.getTsaSubject());
+                response.put("tsaIssuer", verification.getTsaIssuer());
+                response.put("timestamp", verification.getTimestamp().toString());
+            }
+
+            return ResponseEntity.ok(response);
+
+        } catch (Exception e) {
+            response.put("verified", false);
+            response.put("message", "Error al verificar el registro de evidencia: " + e.getMessage());
+            return ResponseEntity.status(HttpStatus.INTERNAL_SERVER_ERROR).body(response);
+        }
+    }
+
     @PostMapping(value = "/certificate-info", consumes = MediaType.MULTIPART_FORM_DATA_VALUE)
     public ResponseEntity<Map<String, Object>> getCertificateInfo(
             @RequestParam("certificate") MultipartFile certificate,
@@ -171,8 +359,43 @@ public class DigitalSignatureController {
         return ResponseEntity.ok(response);
     }
 
+    @GetMapping("/jobs/{jobId}")
+    public ResponseEntity<?> getJobStatus(@PathVariable String jobId) {
+        try {
+            Optional<SigningJobQueue.JobStatus> status = signingJobQueue.status(jobId);
+            return status.<ResponseEntity<?>>map(ResponseEntity::ok)
+                .orElseGet(() -> ResponseEntity.notFound().build());
+        } catch (Exception e) {
+            return ResponseEntity.status(HttpStatus.INTERNAL_SERVER_ERROR)
+                .body(Map.of("error", "Failed to read job status: " + e.getMessage()));
+        }
+    }
+
+    @GetMapping("/jobs/{jobId}/result")
+    public ResponseEntity<?> getJobResult(@PathVariable String jobId) {
+        try {
+            Optional<SigningJobQueue.JobStatus> status = signingJobQueue.status(jobId);
+            if (status.isEmpty()) {
+                return ResponseEntity.notFound().build();
+            }
+            Optional<Path> result = signingJobQueue.resultPath(jobId);
+            if (result.isEmpty()) {
+                // Still queued or running, or failed
+                HttpStatus httpStatus = status.get().getState() == SigningJobQueue.JobState.FAILED ?
+                    HttpStatus.UNPROCESSABLE_ENTITY : HttpStatus.ACCEPTED;
+                return ResponseEntity.status(httpStatus).body(status.get());
+            }
+
+            return fileResponse(result.get(), status.get().getFilename(), new HttpHeaders());
+
+        } catch (Exception e) {
+            return ResponseEntity.status(HttpStatus.INTERNAL_SERVER_ERROR)
+                .body(Map.of("error", "Failed to read job result: " + e.getMessage()));
+        }
+    }
+
     @GetMapping("/download/{documentId}")
-    public ResponseEntity<byte[]> downloadDocument(@PathVariable String documentId) {
+    public ResponseEntity<?> downloadDocument(@PathVariable String documentId) {
         try {
             DocumentStorageService.StoredDocument document = documentStorageService.getDocument(documentId);
             
@@ -180,20 +403,48 @@ public class DigitalSignatureController {
                 return ResponseEntity.notFound().build();
             }
 
-            HttpHeaders headers = new HttpHeaders();
-            headers.setContentType(MediaType.APPLICATION_PDF);
-            headers.setContentDispositionFormData("attachment", document.getFilename());
-            headers.setContentLength(document.getData().length);
-
-            return ResponseEntity.ok()
-                .headers(headers)
-                .body(document.getData());
+            return fileResponse(document.getPath(), document.getFilename(), new HttpHeaders());
 
         } catch (Exception e) {
             return ResponseEntity.status(HttpStatus.INTERNAL_SERVER_ERROR).build();
         }
     }
 
+    /**
+     * Sends a PDF from disk. With X-Accel-Redirect enabled the body is left
+     * empty and nginx serves the file from its internal storage location;
+     * otherwise the file is streamed without loading it into the heap.
+     */
+    private ResponseEntity<?> fileResponse(Path file, String filename, HttpHeaders headers) {
+        headers.set(HttpHeaders.CONTENT_DISPOSITION, "attachment; filename=\"" + filename + "\"");
+        headers.setContentType(MediaType.APPLICATION_PDF);
+
+        Optional<String> accelRedirect = documentStorageService.accelRedirectUri(file);
+        if (accelRedirect.isPresent()) {
+            headers.set("X-Accel-Redirect", accelRedirect.get());
+            return ResponseEntity.ok().headers(headers).build();
+        }
+        return ResponseEntity.ok().headers(headers).body(new FileSystemResource(file));
+    }
+
+    private ResponseEntity<?> compactionRefused() {
+        return ResponseEntity.status(HttpStatus.CONFLICT)
+            .body(Map.of(
+                "error", "Compaction is not allowed on documents that already carry signatures",
+                "code", "ALREADY_SIGNED"));
+    }
+
+    private HttpHeaders compactionHeaders(PdfCompactionService.CompactionResult compaction) {
+        HttpHeaders headers = new HttpHeaders();
+        if (compaction != null) {
+            headers.add("X-Compaction-Original-Size", String.valueOf(compaction.getOriginalSize()));
+            headers.add("X-Compaction-Compacted-Size", String.valueOf(compaction.getCompactedSize()));
+            headers.add("X-Compaction-Deduplicated-Streams", String.valueOf(compaction.getDeduplicatedStreams()));
+            headers.add("X-Compaction-Millis", String.valueOf(compaction.getElapsedMillis()));
+        }
+        return headers;
+    }
+
     private boolean isPdfFile(MultipartFile file) {
         String contentType = file.getContentType();
         String filename = file.getOriginalFilename();
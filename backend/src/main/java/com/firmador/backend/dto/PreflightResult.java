@@ -0,0 +1,100 @@
+package com.firmador.backend.dto;
+
+public class PreflightResult {
+
+    public enum Status {
+        OK,
+        NOT_PDF,
+        TRUNCATED,
+        BROKEN_XREF,
+        ENCRYPTED,
+        PAGE_OUT_OF_RANGE
+    }
+
+    private Status status;
+    private String message;
+    private String pdfVersion;
+    private long fileSize;
+    // Null when the page count could not be located from the head or tail
+    private Integer pageCount;
+    private boolean encrypted;
+    private boolean hasExistingSignatures;
+    private long elapsedMillis;
+
+    // Constructors
+    public PreflightResult() {}
+
+    public PreflightResult(Status status, String message) {
+        this.status = status;
+        this.message = message;
+    }
+
+    public boolean isOk() {
+        return status == Status.OK;
+    }
+
+    // Getters and Setters
+    public Status getStatus() {
+        return status;
+    }
+
+    public void setStatus(Status status) {
+        this.status = status;
+    }
+
+    public String getMessage() {
+        return message;
+    }
+
+    public void setMessage(String message) {
+        this.message = message;
+    }
+
+    public String getPdfVersion() {
+        return pdfVersion;
+    }
+
+    public void setPdfVersion(String pdfVersion) {
+        this.pdfVersion = pdfVersion;
+    }
+
+    public long getFileSize() {
+        return fileSize;
+    }
+
+    public void setFileSize(long fileSize) {
+        this.fileSize = fileSize;
+    }
+
+    public Integer getPageCount() {
+        return pageCount;
+    }
+
+    public void setPageCount(Integer pageCount) {
+        this.pageCount = pageCount;
+    }
+
+    public boolean isEncrypted() {
+        return encrypted;
+    }
+
+    public void setEncrypted(boolean encrypted) {
+        this.encrypted = encrypted;
+    }
+
+    public boolean isHasExistingSignatures() {
+        return hasExistingSignatures;
+    }
+
+    public void setHasExistingSignatures(boolean hasExistingSignatures) {
+        this.hasExistingSignatures = hasExistingSignatures;
+    }
+
+    public long getElapsedMillis() {
+        return elapsedMillis;
+    }
+
+    public void setElapsedMillis(long elapsedMillis) {
+        this.elapsedMillis = elapsedMillis;
+    }
+}
@@ -33,6 +33,7 @@ public class SignatureRequest {
     // Timestamp settings
     private Boolean enableTimestamp = false;
     private String timestampServerUrl = "https://freetsa.org/tsr";
+    private Boolean batchTimestamp = false;
     
     // Constructors
     public SignatureRequest() {}
@@ -152,4 +153,12 @@ public class SignatureRequest {
     public void setTimestampServerUrl(String timestampServerUrl) {
         this.timestampServerUrl = timestampServerUrl;
     }
+    
+    public Boolean getBatchTimestamp() {
+        return batchTimestamp;
+    }
+    
+    public void setBatchTimestamp(Boolean batchTimestamp) {
+        this.batchTimestamp = batchTimestamp;
+    }
 } 
\ No newline at end of file
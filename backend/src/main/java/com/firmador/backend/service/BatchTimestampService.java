@@ -0,0 +1,578 @@
+package com.firmador.backend.service;
+
+import com.itextpdf.kernel.pdf.*;
+import com.itextpdf.signatures.SignatureUtil;
+import com.itextpdf.signatures.TSAClientBouncyCastle;
+import jakarta.annotation.PreDestroy;
+import org.bouncycastle.asn1.*;
+import org.bouncycastle.asn1.cms.ContentInfo;
+import org.bouncycastle.asn1.nist.NISTObjectIdentifiers;
+import org.bouncycastle.asn1.x509.AlgorithmIdentifier;
+import org.bouncycastle.asn1.x509.KeyPurposeId;
+import org.bouncycastle.cert.X509CertificateHolder;
+import org.bouncycastle.cert.jcajce.JcaX509CertificateConverter;
+import org.bouncycastle.cms.CMSSignedData;
+import org.bouncycastle.cms.jcajce.JcaSimpleSignerInfoVerifierBuilder;
+import org.bouncycastle.jce.provider.BouncyCastleProvider;
+import org.bouncycastle.tsp.TimeStampToken;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.stereotype.Service;
+
+import javax.net.ssl.TrustManager;
+import javax.net.ssl.TrustManagerFactory;
+import javax.net.ssl.X509TrustManager;
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.net.HttpURLConnection;
+import java.net.URL;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.security.GeneralSecurityException;
+import java.security.KeyStore;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.security.Security;
+import java.security.cert.*;
+import java.time.Instant;
+import java.util.*;
+import java.util.concurrent.*;
+
+/**
+ * Aggregates document hashes arriving within a short window into a Merkle
+ * tree and timestamps only its root, so a burst of signatures costs a single
+ * TSA round trip.
+ *
+ * Each document receives an RFC 4998 EvidenceRecord holding the root's
+ * RFC 3161 token and the reduced hash tree (inclusion proof) for its own
+ * hash, which can be checked offline with {@link #verify(byte[], byte[])}.
+ * Tree nodes follow RFC 4998: a parent is the hash of its children's hashes
+ * concatenated in ascending binary order, so proofs need no left/right flags.
+ *
+ * Verification only accepts tokens whose TSA certificate carries the
+ * id-kp-timeStamping extended key usage and chains, at the token's time, to
+ * {@code firmador.timestamp.trust-store} (the JDK's cacerts when unset).
+ */
+@Service
+public class BatchTimestampService {
+
+    private static final Logger logger = LoggerFactory.getLogger(BatchTimestampService.class);
+
+    private static final AlgorithmIdentifier SHA256 = new AlgorithmIdentifier(NISTObjectIdentifiers.id_sha256);
+    private static final String NOT_COVERED = "El hash del documento no está cubierto por el registro de evidencia";
+
+    /** Outcome of checking an evidence record, with the TSA that vouched for it. */
+    public static class Verification {
+        private final boolean valid;
+        private final String message;
+        private final String tsaSubject;
+        private final String tsaIssuer;
+        private final Instant timestamp;
+
+        public Verification(boolean valid, String message, String tsaSubject, String tsaIssuer, Instant timestamp) {
+            this.valid = valid;
+            this.message = message;
+            this.tsaSubject = tsaSubject;
+            this.tsaIssuer = tsaIssuer;
+            this.timestamp = timestamp;
+        }
+
+        static Verification invalid(String message) {
+            return new Verification(false, message, null, null, null);
+        }
+
+        public boolean isValid() { return valid; }
+        public String getMessage() { return message; }
+        public String getTsaSubject() { return tsaSubject; }
+        public String getTsaIssuer() { return tsaIssuer; }
+        public Instant getTimestamp() { return timestamp; }
+    }
+
+    private static class Leaf {
+        final byte[] hash;
+        final CompletableFuture<byte[]> evidenceRecord = new CompletableFuture<>();
+
+        Leaf(byte[] hash) {
+            this.hash = hash;
+        }
+    }
+
+    private static class Batch {
+        final String tsaUrl;
+        final List<Leaf> leaves = new ArrayList<>();
+
+        Batch(String tsaUrl) {
+            this.tsaUrl = tsaUrl;
+        }
+    }
+
+    private final long windowMillis;
+    private final int maxBatchSize;
+    private final long tsaTimeoutMillis;
+    private final int tsaRequestTimeoutMillis;
+    private final Set<TrustAnchor> trustAnchors;
+    private final Map<String, Batch> openBatches = new HashMap<>();
+    // Only closes windows; TSA round trips run on tsaExecutor so a slow or
+    // unresponsive TSA cannot hold back the timers of later windows
+    private final ScheduledExecutorService scheduler;
+    private final ExecutorService tsaExecutor;
+
+    public BatchTimestampService(@Value("${firmador.timestamp.batch-window-millis:2000}") long windowMillis,
+                                 @Value("${firmador.timestamp.batch-max-size:1024}") int maxBatchSize,
+                                 @Value("${firmador.timestamp.tsa-timeout-millis:30000}") long tsaTimeoutMillis,
+                                 @Value("${firmador.timestamp.tsa-request-timeout-millis:10000}") int tsaRequestTimeoutMillis,
+                                 @Value("${firmador.timestamp.trust-store:}") String trustStorePath,
+                                 @Value("${firmador.timestamp.trust-store-password:}") String trustStorePassword,
+                                 @Value("${firmador.timestamp.trust-store-type:PKCS12}") String trustStoreType)
+            throws GeneralSecurityException, IOException {
+        this.windowMillis = windowMillis;
+        this.maxBatchSize = maxBatchSize;
+        this.tsaTimeoutMillis = tsaTimeoutMillis;
+        this.tsaRequestTimeoutMillis = tsaRequestTimeoutMillis;
+        this.trustAnchors = loadTrustAnchors(trustStorePath, trustStorePassword, trustStoreType);
+        if (Security.getProvider("BC") == null) {
+            Security.addProvider(new BouncyCastleProvider());
+        }
+        this.scheduler = Executors.newSingleThreadScheduledExecutor(runnable -> {
+            Thread thread = new Thread(runnable, "batch-timestamp");
+            thread.setDaemon(true);
+            return thread;
+        });
+        this.tsaExecutor = Executors.newCachedThreadPool(runnable -> {
+            Thread thread = new Thread(runnable, "batch-timestamp-tsa");
+            thread.setDaemon(true);
+            return thread;
+        });
+    }
+
+    private static Set<TrustAnchor> loadTrustAnchors(String path, String password, String type)
+            throws GeneralSecurityException, IOException {
+        KeyStore keyStore = null;
+        if (path != null && !path.isBlank()) {
+            keyStore = KeyStore.getInstance(type);
+            try (InputStream in = Files.newInputStream(Paths.get(path))) {
+                keyStore.load(in, password == null || password.isEmpty() ? null : password.toCharArray());
+            }
+        }
+        // A null key store makes the factory fall back to the JDK's cacerts
+        TrustManagerFactory factory = TrustManagerFactory.getInstance(TrustManagerFactory.getDefaultAlgorithm());
+        factory.init(keyStore);
+        Set<TrustAnchor> anchors = new HashSet<>();
+        for (TrustManager trustManager : factory.getTrustManagers()) {
+            if (trustManager instanceof X509TrustManager) {
+                for (X509Certificate certificate : ((X509TrustManager) trustManager).getAcceptedIssuers()) {
+                    anchors.add(new TrustAnchor(certificate, null));
+                }
+            }
+        }
+        if (anchors.isEmpty()) {
+            throw new IllegalStateException("No trusted certificates for TSA verification in " + path);
+        }
+        logger.info("Verifying TSA certificates against {} trust anchors from {}",
+            anchors.size(), keyStore != null ? path : "the JDK cacerts");
+        return anchors;
+    }
+
+    @PreDestroy
+    public void shutdown() {
+        scheduler.shutdownNow();
+        tsaExecutor.shutdownNow();
+    }
+
+    /**
+     * Adds {@code documentHash} (SHA-256) to the open batch for {@code tsaUrl}
+     * and blocks until the batch is timestamped. Returns the DER-encoded
+     * EvidenceRecord for this hash.
+     */
+    public byte[] timestamp(byte[] documentHash, String tsaUrl) throws Exception {
+        Leaf leaf = new Leaf(documentHash);
+        Batch full = null;
+        synchronized (openBatches) {
+            Batch batch = openBatches.get(tsaUrl);
+            if (batch == null) {
+                Batch opened = new Batch(tsaUrl);
+                openBatches.put(tsaUrl, opened);
+                scheduler.schedule(() -> flush(opened), windowMillis, TimeUnit.MILLISECONDS);
+                batch = opened;
+            }
+            batch.leaves.add(leaf);
+            if (batch.leaves.size() >= maxBatchSize) {
+                full = batch;
+            }
+        }
+        if (full != null) {
+            flush(full);
+        }
+
+        try {
+            return leaf.evidenceRecord.get(windowMillis + tsaTimeoutMillis, TimeUnit.MILLISECONDS);
+        } catch (ExecutionException e) {
+            throw e.getCause() instanceof Exception ? (Exception) e.getCause() : e;
+        }
+    }
+
+    private void flush(Batch batch) {
+        synchronized (openBatches) {
+            // Already flushed because it filled up before the window closed
+            if (openBatches.get(batch.tsaUrl) != batch) {
+                return;
+            }
+            openBatches.remove(batch.tsaUrl);
+        }
+        tsaExecutor.execute(() -> requestTimestamp(batch));
+    }
+
+    /**
+     * Timestamps the batch root, trying the batch's TSA and then the same
+     * fallback servers as single-document signing until one answers or
+     * {@code tsa-timeout-millis} runs out.
+     */
+    private void requestTimestamp(Batch batch) {
+        List<Leaf> leaves = batch.leaves;
+        try {
+            List<List<byte[]>> levels = buildTree(leaves);
+            byte[] root = levels.get(levels.size() - 1).get(0);
+
+            long deadline = System.currentTimeMillis() + tsaTimeoutMillis;
+            byte[] token = null;
+            Exception failure = null;
+            for (String url : tsaServers(batch.tsaUrl)) {
+                long remaining = deadline - System.currentTimeMillis();
+                if (remaining <= 0) {
+                    break;
+                }
+                try {
+                    token = new TimeoutTSAClient(url, (int) Math.min(tsaRequestTimeoutMillis, remaining))
+                        .getTimeStampToken(root);
+                    logger.info("Timestamped batch of {} signatures with one TSA request to {}", leaves.size(), url);
+                    break;
+                } catch (Exception e) {
+                    logger.warn("Batch timestamp request to {} failed: {}", url, e.getMessage());
+                    failure = e;
+                }
+            }
+            if (token == null) {
+                throw failure != null ? failure : new TimeoutException("No TSA answered within " + tsaTimeoutMillis + " ms");
+            }
+
+            ContentInfo timeStamp = ContentInfo.getInstance(ASN1Primitive.fromByteArray(token));
+            for (int i = 0; i < leaves.size(); i++) {
+                leaves.get(i).evidenceRecord.complete(encodeEvidenceRecord(proof(levels, i), timeStamp));
+            }
+        } catch (Exception e) {
+            logger.error("Batch timestamp failed for {} signatures", leaves.size(), e);
+            for (Leaf leaf : leaves) {
+                leaf.evidenceRecord.completeExceptionally(e);
+            }
+        }
+    }
+
+    List<String> tsaServers(String primaryUrl) {
+        return DigitalSignatureService.tsaServers(primaryUrl);
+    }
+
+    /**
+     * TSAClientBouncyCastle opens its connection without timeouts, so an
+     * unresponsive TSA would hold a thread forever; this one bounds both the
+     * connect and every read.
+     */
+    static class TimeoutTSAClient extends TSAClientBouncyCastle {
+        private final String url;
+        private final int timeoutMillis;
+
+        TimeoutTSAClient(String url, int timeoutMillis) {
+            super(url);
+            this.url = url;
+            this.timeoutMillis = timeoutMillis;
+        }
+
+        @Override
+        protected byte[] getTSAResponse(byte[] requestBytes) throws IOException {
+            HttpURLConnection connection = (HttpURLConnection) new URL(url).openConnection();
+            connection.setConnectTimeout(timeoutMillis);
+            connection.setReadTimeout(timeoutMillis);
+            connection.setDoOutput(true);
+            connection.setRequestMethod("POST");
+            connection.setRequestProperty("Content-Type", "application/timestamp-query");
+            connection.setRequestProperty("Content-Transfer-Encoding", "binary");
+            try {
+                try (OutputStream out = connection.getOutputStream()) {
+                    out.write(requestBytes);
+                }
+                int status = connection.getResponseCode();
+                if (status != HttpURLConnection.HTTP_OK) {
+                    throw new IOException("TSA " + url + " answered HTTP " + status);
+                }
+                byte[] response;
+                try (InputStream in = connection.getInputStream()) {
+                    response = in.readAllBytes();
+                }
+                // Same as TSAClientBouncyCastle: some servers answer in base64
+                return "base64".equalsIgnoreCase(connection.getContentEncoding()) ?
+                    Base64.getMimeDecoder().decode(response) : response;
+            } finally {
+                connection.disconnect();
+            }
+        }
+    }
+
+    /**
+     * Returns the tree bottom-up: level 0 holds the leaf hashes, the last
+     * level holds the root. A node without a sibling is hashed on its own.
+     */
+    private List<List<byte[]>> buildTree(List<Leaf> leaves) throws NoSuchAlgorithmException {
+        List<byte[]> hashes = new ArrayList<>();
+        for (Leaf leaf : leaves) {
+            hashes.add(leaf.hash);
+        }
+        return buildTree(hashes);
+    }
+
+    static List<List<byte[]>> buildTree(List<byte[]> hashes) throws NoSuchAlgorithmException {
+        List<List<byte[]>> levels = new ArrayList<>();
+        List<byte[]> level = new ArrayList<>(hashes);
+        levels.add(level);
+
+        do {
+            List<byte[]> parents = new ArrayList<>();
+            for (int i = 0; i < level.size(); i += 2) {
+                parents.add(i + 1 < level.size() ?
+                    hashGroup(List.of(level.get(i), level.get(i + 1))) :
+                    hashGroup(List.of(level.get(i))));
+            }
+            levels.add(parents);
+            level = parents;
+        } while (level.size() > 1);
+        return levels;
+    }
+
+    /**
+     * Reduced hash tree for leaf {@code index} (RFC 4998 section 4.2): the
+     * first list holds the leaf and its sibling, every higher list only the
+     * sibling of the node on the path (empty for a node without one). The
+     * nodes on the path are not stored; the verifier computes each one and
+     * adds it to the next list.
+     */
+    static List<List<byte[]>> proof(List<List<byte[]>> levels, int index) {
+        List<List<byte[]>> reduced = new ArrayList<>();
+        for (int depth = 0; depth < levels.size() - 1; depth++) {
+            List<byte[]> level = levels.get(depth);
+            List<byte[]> group = new ArrayList<>();
+            if (depth == 0) {
+                group.add(level.get(index));
+            }
+            int sibling = index ^ 1;
+            if (sibling < level.size()) {
+                group.add(level.get(sibling));
+            }
+            reduced.add(group);
+            index /= 2;
+        }
+        return reduced;
+    }
+
+    static byte[] hashGroup(List<byte[]> hashes) throws NoSuchAlgorithmException {
+        List<byte[]> sorted = new ArrayList<>(hashes);
+        sorted.sort(Arrays::compareUnsigned);
+        MessageDigest digest = MessageDigest.getInstance("SHA-256");
+        for (byte[] hash : sorted) {
+            digest.update(hash);
+        }
+        return digest.digest();
+    }
+
+    // EvidenceRecord ::= SEQUENCE {
+    //   version INTEGER { v1(1) },
+    //   digestAlgorithms SEQUENCE OF AlgorithmIdentifier,
+    //   archiveTimeStampSequence SEQUENCE OF SEQUENCE OF ArchiveTimeStamp }
+    // ArchiveTimeStamp ::= SEQUENCE {
+    //   digestAlgorithm [0] AlgorithmIdentifier OPTIONAL,
+    //   reducedHashtree [2] SEQUENCE OF SEQUENCE OF OCTET STRING OPTIONAL,
+    //   timeStamp ContentInfo }
+    static byte[] encodeEvidenceRecord(List<List<byte[]>> reducedHashtree, ContentInfo timeStamp) throws IOException {
+        ASN1EncodableVector partialHashtrees = new ASN1EncodableVector();
+        for (List<byte[]> group : reducedHashtree) {
+            ASN1EncodableVector hashes = new ASN1EncodableVector();
+            for (byte[] hash : group) {
+                hashes.add(new DEROctetString(hash));
+            }
+            partialHashtrees.add(new DERSequence(hashes));
+        }
+
+        ASN1EncodableVector archiveTimeStamp = new ASN1EncodableVector();
+        archiveTimeStamp.add(new DERTaggedObject(false, 0, SHA256));
+        archiveTimeStamp.add(new DERTaggedObject(false, 2, new DERSequence(partialHashtrees)));
+        archiveTimeStamp.add(timeStamp);
+
+        ASN1EncodableVector evidenceRecord = new ASN1EncodableVector();
+        evidenceRecord.add(new ASN1Integer(1));
+        evidenceRecord.add(new DERSequence(SHA256));
+        evidenceRecord.add(new DERSequence(new DERSequence(new DERSequence(archiveTimeStamp))));
+        return new DERSequence(evidenceRecord).getEncoded(ASN1Encoding.DER);
+    }
+
+    /**
+     * Checks every evidence record embedded in a signed PDF against the
+     * signed revisions it contains. Fails when the document carries no
+     * evidence record.
+     */
+    public Verification verifyDocument(byte[] pdfBytes) throws IOException {
+        List<byte[]> evidenceRecords = new ArrayList<>();
+        List<byte[]> revisionHashes = new ArrayList<>();
+        try (PdfDocument pdfDocument = new PdfDocument(new PdfReader(new ByteArrayInputStream(pdfBytes)))) {
+            for (PdfObject value : pdfDocument.getCatalog().getNameTree(PdfName.EmbeddedFiles).getNames().values()) {
+                PdfDictionary fileSpec = value instanceof PdfDictionary ? (PdfDictionary) value : null;
+                PdfDictionary embedded = fileSpec != null ? fileSpec.getAsDictionary(PdfName.EF) : null;
+                PdfStream stream = embedded != null ? embedded.getAsStream(PdfName.F) : null;
+                PdfString name = fileSpec != null ? fileSpec.getAsString(PdfName.F) : null;
+                if (stream != null && name != null && name.toUnicodeString().endsWith(".ers")) {
+                    evidenceRecords.add(stream.getBytes());
+                }
+            }
+
+            SignatureUtil signatureUtil = new SignatureUtil(pdfDocument);
+            for (String signatureName : signatureUtil.getSignatureNames()) {
+                try (InputStream revision = signatureUtil.extractRevision(signatureName)) {
+                    MessageDigest digest = MessageDigest.getInstance("SHA-256");
+                    revisionHashes.add(digest.digest(revision.readAllBytes()));
+                }
+            }
+        } catch (NoSuchAlgorithmException e) {
+            throw new IllegalStateException(e);
+        }
+
+        if (evidenceRecords.isEmpty()) {
+            return Verification.invalid("El documento no contiene registros de evidencia");
+        }
+        Verification last = null;
+        for (byte[] evidenceRecord : evidenceRecords) {
+            Verification matched = null;
+            Verification failure = Verification.invalid(NOT_COVERED);
+            for (byte[] revisionHash : revisionHashes) {
+                Verification verification = verify(revisionHash, evidenceRecord);
+                if (verification.isValid()) {
+                    matched = verification;
+                    break;
+                }
+                // Report why the revision the record covers failed, not the misses
+                if (!NOT_COVERED.equals(verification.getMessage())) {
+                    failure = verification;
+                }
+            }
+            if (matched == null) {
+                return failure;
+            }
+            last = matched;
+        }
+        return last;
+    }
+
+    /**
+     * Offline check of an evidence record: the document hash must chain up
+     * the reduced hash tree to the hash inside the timestamp token, and the
+     * token must carry a valid signature from a trusted TSA.
+     */
+    public Verification verify(byte[] documentHash, byte[] evidenceRecord) {
+        try {
+            ASN1Sequence record = ASN1Sequence.getInstance(evidenceRecord);
+            ASN1Sequence chains = ASN1Sequence.getInstance(record.getObjectAt(record.size() - 1));
+            ASN1Sequence archiveTimeStamp = ASN1Sequence.getInstance(
+                ASN1Sequence.getInstance(chains.getObjectAt(0)).getObjectAt(0));
+
+            byte[] current = documentHash;
+            ContentInfo timeStamp = null;
+            for (ASN1Encodable element : archiveTimeStamp) {
+                if (element instanceof ASN1TaggedObject && ((ASN1TaggedObject) element).getTagNo() == 2) {
+                    ASN1Sequence reduced = ASN1Sequence.getInstance((ASN1TaggedObject) element, false);
+                    boolean first = true;
+                    for (ASN1Encodable partial : reduced) {
+                        List<byte[]> group = new ArrayList<>();
+                        boolean found = false;
+                        for (ASN1Encodable hash : ASN1Sequence.getInstance(partial)) {
+                            byte[] value = ASN1OctetString.getInstance(hash).getOctets();
+                            found |= Arrays.equals(value, current);
+                            group.add(value);
+                        }
+                        // RFC 4998 section 5.3: the document hash must be in the
+                        // first list; each computed parent joins the next one
+                        if (first && !found) {
+                            return Verification.invalid(NOT_COVERED);
+                        }
+                        if (!first) {
+                            group.add(current);
+                        }
+                        current = hashGroup(group);
+                        first = false;
+                    }
+                } else if (!(element instanceof ASN1TaggedObject)) {
+                    timeStamp = ContentInfo.getInstance(element);
+                }
+            }
+            if (timeStamp == null) {
+                return Verification.invalid("El registro de evidencia no contiene sello de tiempo");
+            }
+
+            TimeStampToken token = new TimeStampToken(new CMSSignedData(timeStamp));
+            if (!Arrays.equals(token.getTimeStampInfo().getMessageImprintDigest(), current)) {
+                return Verification.invalid(NOT_COVERED);
+            }
+            @SuppressWarnings("unchecked")
+            Collection<X509CertificateHolder> signers = token.getCertificates().getMatches(token.getSID());
+            if (signers.isEmpty()) {
+                return Verification.invalid("El sello no incluye el certificado de la TSA");
+            }
+            JcaX509CertificateConverter converter = new JcaX509CertificateConverter().setProvider("BC");
+            X509Certificate tsaCertificate = converter.getCertificate(signers.iterator().next());
+            token.validate(new JcaSimpleSignerInfoVerifierBuilder().setProvider("BC").build(tsaCertificate));
+
+            List<String> extendedKeyUsage = tsaCertificate.getExtendedKeyUsage();
+            if (extendedKeyUsage == null || !extendedKeyUsage.contains(KeyPurposeId.id_kp_timeStamping.getId())) {
+                return Verification.invalid("El certificado de la TSA no está autorizado para sellar tiempo");
+            }
+            Date genTime = token.getTimeStampInfo().getGenTime();
+            try {
+                buildTrustedPath(tsaCertificate, token, converter, genTime);
+            } catch (CertPathBuilderException e) {
+                logger.warn("Untrusted TSA certificate {}: {}", tsaCertificate.getSubjectX500Principal(), e.getMessage());
+                return Verification.invalid("El certificado de la TSA no es de confianza: " +
+                    tsaCertificate.getSubjectX500Principal().getName());
+            }
+
+            return new Verification(true, "Registro de evidencia válido",
+                tsaCertificate.getSubjectX500Principal().getName(),
+                tsaCertificate.getIssuerX500Principal().getName(),
+                genTime.toInstant());
+        } catch (Exception e) {
+            logger.warn("Evidence record verification failed: {}", e.getMessage());
+            return Verification.invalid("Registro de evidencia inválido: " + e.getMessage());
+        }
+    }
+
+    /**
+     * Builds a path from the TSA certificate to a trust anchor, using the
+     * certificates shipped in the token as intermediates. The path is checked
+     * at the token's generation time, as archived tokens outlive their TSA
+     * certificates; revocation is not checked offline.
+     */
+    private void buildTrustedPath(X509Certificate tsaCertificate, TimeStampToken token,
+                                  JcaX509CertificateConverter converter, Date genTime)
+            throws GeneralSecurityException {
+        List<X509Certificate> intermediates = new ArrayList<>();
+        @SuppressWarnings("unchecked")
+        Collection<X509CertificateHolder> shipped = token.getCertificates().getMatches(null);
+        for (X509CertificateHolder holder : shipped) {
+            intermediates.add(converter.getCertificate(holder));
+        }
+
+        X509CertSelector target = new X509CertSelector();
+        target.setCertificate(tsaCertificate);
+        PKIXBuilderParameters parameters = new PKIXBuilderParameters(trustAnchors, target);
+        parameters.addCertStore(CertStore.getInstance("Collection", new CollectionCertStoreParameters(intermediates)));
+        parameters.setRevocationEnabled(false);
+        parameters.setDate(genTime);
+        CertPathBuilder.getInstance("PKIX").build(parameters);
+    }
+}
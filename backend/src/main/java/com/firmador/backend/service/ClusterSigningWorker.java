@@ -0,0 +1,136 @@
+package com.firmador.backend.service;
+
+import jakarta.annotation.PostConstruct;
+import jakarta.annotation.PreDestroy;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.boot.autoconfigure.condition.ConditionalOnProperty;
+import org.springframework.scheduling.annotation.Scheduled;
+import org.springframework.stereotype.Component;
+
+import java.util.Optional;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ThreadLocalRandom;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Pulls jobs from the shared {@link SigningJobQueue} and signs them. Every
+ * instance started with cluster mode enabled runs one of these, so adding
+ * instances adds signing capacity.
+ */
+@Component
+@ConditionalOnProperty(name = "firmador.cluster.enabled", havingValue = "true")
+public class ClusterSigningWorker {
+
+    private static final Logger logger = LoggerFactory.getLogger(ClusterSigningWorker.class);
+
+    private final SigningJobQueue queue;
+    private final DigitalSignatureService digitalSignatureService;
+    private final int workers;
+    private final long pollMillis;
+    private final Set<String> activeJobs = ConcurrentHashMap.newKeySet();
+    private final Set<String> lostJobs = ConcurrentHashMap.newKeySet();
+
+    private ExecutorService executor;
+    private volatile boolean running;
+
+    public ClusterSigningWorker(SigningJobQueue queue,
+                                DigitalSignatureService digitalSignatureService,
+                                @Value("${firmador.cluster.workers:0}") int workers,
+                                @Value("${firmador.cluster.poll-millis:500}") long pollMillis) {
+        this.queue = queue;
+        this.digitalSignatureService = digitalSignatureService;
+        this.workers = workers > 0 ? workers : Runtime.getRuntime().availableProcessors();
+        this.pollMillis = pollMillis;
+    }
+
+    @PostConstruct
+    public void start() {
+        AtomicInteger threadNumber = new AtomicInteger();
+        executor = Executors.newFixedThreadPool(workers, runnable -> {
+            Thread thread = new Thread(runnable, "signing-worker-" + threadNumber.incrementAndGet());
+            thread.setDaemon(true);
+            return thread;
+        });
+        running = true;
+        for (int i = 0; i < workers; i++) {
+            executor.submit(this::runWorker);
+        }
+        logger.info("Started {} signing workers on instance {}", workers, queue.getInstanceId());
+    }
+
+    @PreDestroy
+    public void stop() throws InterruptedException {
+        running = false;
+        executor.shutdownNow();
+        executor.awaitTermination(30, TimeUnit.SECONDS);
+    }
+
+    private void runWorker() {
+        while (running && !Thread.currentThread().isInterrupted()) {
+            try {
+                Optional<SigningJobQueue.ClaimedJob> claimed = queue.claim();
+                if (claimed.isEmpty()) {
+                    // Jittered so the workers of every instance do not list
+                    // the shared directory in lockstep
+                    Thread.sleep(pollMillis / 2 + ThreadLocalRandom.current().nextLong(pollMillis + 1));
+                    continue;
+                }
+                process(claimed.get());
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+            } catch (Exception e) {
+                logger.error("Signing worker error", e);
+            }
+        }
+    }
+
+    private void process(SigningJobQueue.ClaimedJob job) throws Exception {
+        activeJobs.add(job.getJobId());
+        try {
+            byte[] signedPdf = digitalSignatureService.signPdf(job.getDocument(), job.getRequest());
+            if (lostJobs.contains(job.getJobId())) {
+                logger.warn("Discarding job {}: its lease was lost while signing", job.getJobId());
+                return;
+            }
+            String signedFilename = job.getFilename().replaceFirst("(\\.[^.]*)?$", "_signed$1");
+            if (queue.complete(job.getJobId(), signedPdf, signedFilename)) {
+                logger.info("Job {} signed on instance {}", job.getJobId(), queue.getInstanceId());
+            }
+        } catch (RuntimeException e) {
+            logger.error("Job {} failed", job.getJobId(), e);
+            if (!lostJobs.contains(job.getJobId())) {
+                queue.fail(job.getJobId(), e.getMessage());
+            }
+        } finally {
+            activeJobs.remove(job.getJobId());
+            lostJobs.remove(job.getJobId());
+        }
+    }
+
+    @Scheduled(fixedDelayString = "${firmador.cluster.heartbeat-seconds:15}", timeUnit = TimeUnit.SECONDS)
+    public void heartbeat() {
+        for (String jobId : activeJobs) {
+            if (!lostJobs.contains(jobId) && !queue.heartbeat(jobId)) {
+                // Another instance may already be running it; this one must not publish or clean it up
+                lostJobs.add(jobId);
+                logger.warn("Lost lease on job {}; its result will be discarded", jobId);
+            }
+        }
+    }
+
+    @Scheduled(fixedDelayString = "${firmador.cluster.heartbeat-seconds:15}", timeUnit = TimeUnit.SECONDS)
+    public void reap() {
+        try {
+            queue.reapExpiredLeases();
+            queue.purgeExpired();
+        } catch (Exception e) {
+            logger.warn("Could not reap signing queue: {}", e.getMessage());
+        }
+    }
+}
@@ -2,17 +2,27 @@ package com.firmador.backend.service;
 
 import com.firmador.backend.dto.SignatureRequest;
 import com.firmador.backend.dto.CertificateInfo;
+import com.itextpdf.kernel.pdf.PdfDocument;
+import com.itextpdf.kernel.pdf.PdfName;
 import com.itextpdf.kernel.pdf.PdfReader;
+import com.itextpdf.kernel.pdf.PdfWriter;
 import com.itextpdf.kernel.pdf.StampingProperties;
+import com.itextpdf.kernel.pdf.filespec.PdfFileSpec;
 import com.itextpdf.kernel.geom.Rectangle;
 import com.itextpdf.signatures.*;
 import org.bouncycastle.jce.provider.BouncyCastleProvider;
+import org.springframework.beans.factory.annotation.Value;
 import org.springframework.stereotype.Service;
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 
 import java.io.ByteArrayInputStream;
 import java.io.ByteArrayOutputStream;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.StandardCopyOption;
 import java.security.*;
 import java.security.cert.Certificate;
 import java.security.cert.X509Certificate;
@@ -21,7 +31,10 @@ import java.time.format.DateTimeFormatter;
 import java.time.Instant;
 import java.time.ZoneId;
 import java.time.ZonedDateTime;
+import java.util.Arrays;
 import java.util.Date;
+import java.util.List;
+import java.util.stream.Stream;
 
 @Service
 public class DigitalSignatureService {
@@ -81,10 +94,21 @@ public class DigitalSignatureService {
         }
     }
 
+    private static final String EVIDENCE_RECORD_FILENAME = "evidence-record.ers";
+
     private final CertificateService certificateService;
+    private final BatchTimestampService batchTimestampService;
+    private final SignatureProviderSelector signatureProviderSelector;
+    private final long lazyThresholdBytes;
 
-    public DigitalSignatureService(CertificateService certificateService) {
+    public DigitalSignatureService(CertificateService certificateService,
+                                   BatchTimestampService batchTimestampService,
+                                   SignatureProviderSelector signatureProviderSelector,
+                                   @Value("${firmador.signature.lazy-threshold-mb:16}") long lazyThresholdMb) {
         this.certificateService = certificateService;
+        this.batchTimestampService = batchTimestampService;
+        this.signatureProviderSelector = signatureProviderSelector;
+        this.lazyThresholdBytes = lazyThresholdMb * 1024 * 1024;
     }
 
     /**
@@ -158,25 +182,31 @@ public class DigitalSignatureService {
         }
     }
 
+    // Fallback TSA servers in order of preference and reliability
+    private static final String[] FALLBACK_TSA_SERVERS = {
+        "https://freetsa.org/tsr",           // Most reliable free TSA
+        "http://timestamp.digicert.com",     // DigiCert public TSA
+        "http://timestamp.apple.com/ts01",   // Apple TSA
+        "http://time.certum.pl",            // Certum TSA
+        "http://timestamp.sectigo.com",      // Sectigo TSA
+    };
+
+    /**
+     * The user selected server followed by the fallback servers, without
+     * duplicates. Shared with batch timestamping.
+     */
+    static List<String> tsaServers(String primaryUrl) {
+        return Stream.concat(Stream.of(primaryUrl), Arrays.stream(FALLBACK_TSA_SERVERS))
+            .filter(url -> url != null && !url.trim().isEmpty())
+            .distinct()
+            .toList();
+    }
+
     /**
      * Try multiple TSA servers as fallback with better error handling and retry logic
      */
     private ITSAClient createTSAClientWithFallback(String primaryUrl) {
-        // List of fallback TSA servers in order of preference and reliability
-        String[] fallbackServers = {
-            primaryUrl,                          // User selected server (try first)
-            "https://freetsa.org/tsr",           // Most reliable free TSA
-            "http://timestamp.digicert.com",     // DigiCert public TSA
-            "http://timestamp.apple.com/ts01",   // Apple TSA
-            "http://time.certum.pl",            // Certum TSA
-            "http://timestamp.sectigo.com",      // Sectigo TSA
-        };
-        
-        // Remove duplicates while preserving order
-        String[] uniqueServers = java.util.Arrays.stream(fallbackServers)
-            .distinct()
-            .filter(url -> url != null && !url.trim().isEmpty())
-            .toArray(String[]::new);
+        String[] uniqueServers = tsaServers(primaryUrl).toArray(String[]::new);
         
         for (int i = 0; i < uniqueServers.length; i++) {
             String url = uniqueServers[i];
@@ -287,7 +317,49 @@ public class DigitalSignatureService {
         }
     }
 
+    /**
+     * Private key and certificate chain unlocked from a PKCS#12 container.
+     */
+    public static class SigningKey {
+        private final String alias;
+        private final PrivateKey privateKey;
+        private final Certificate[] certificateChain;
+
+        public SigningKey(String alias, PrivateKey privateKey, Certificate[] certificateChain) {
+            this.alias = alias;
+            this.privateKey = privateKey;
+            this.certificateChain = certificateChain;
+        }
+
+        public String getAlias() { return alias; }
+        public PrivateKey getPrivateKey() { return privateKey; }
+        public Certificate[] getCertificateChain() { return certificateChain; }
+    }
+
+    public SigningKey loadSigningKey(byte[] certificateData, String password) throws Exception {
+        KeyStore keystore = loadKeyStore(certificateData, password);
+        String alias = keystore.aliases().nextElement();
+        PrivateKey privateKey = (PrivateKey) keystore.getKey(alias, password.toCharArray());
+        Certificate[] certificateChain = keystore.getCertificateChain(alias);
+        return new SigningKey(alias, privateKey, certificateChain);
+    }
+
     public byte[] signPdf(byte[] pdfBytes, SignatureRequest request) {
+        SigningKey signingKey;
+        try {
+            signingKey = loadSigningKey(request.getCertificateData(), request.getCertificatePassword());
+        } catch (Exception e) {
+            logger.error("Error loading certificate for signer: {}", request.getSignerName(), e);
+            throw new RuntimeException("Failed to sign PDF: " + e.getMessage(), e);
+        }
+        return signPdf(pdfBytes, request, signingKey);
+    }
+
+    /**
+     * Signs with a key unlocked beforehand, so callers can decrypt the
+     * PKCS#12 container while the document is still arriving.
+     */
+    public byte[] signPdf(byte[] pdfBytes, SignatureRequest request, SigningKey signingKey) {
         try {
             logger.info("Starting PDF signing process for signer: {}", request.getSignerName());
             
@@ -297,114 +369,258 @@ public class DigitalSignatureService {
             
             // Create signed PDF with external container
             PdfSigner signer = new PdfSigner(reader, outputStream, new StampingProperties());
+            sign(signer, request, signingKey);
             
-            // Load certificate and private key
-            KeyStore keystore = loadKeyStore(request.getCertificateData(), request.getCertificatePassword());
-            String alias = keystore.aliases().nextElement();
-            PrivateKey privateKey = (PrivateKey) keystore.getKey(alias, request.getCertificatePassword().toCharArray());
-            Certificate[] certificateChain = keystore.getCertificateChain(alias);
-            
-            logger.info("Certificate loaded successfully for alias: {}", alias);
-            
-            // Create external signature container
-            IExternalSignature externalSignature = new PrivateKeySignature(privateKey, DigestAlgorithms.SHA256, "BC");
+            if (isBatchTimestamp(request)) {
+                return attachEvidenceRecord(outputStream.toByteArray(), request.getTimestampServerUrl());
+            }
+            return outputStream.toByteArray();
             
-            // Create TSA client if timestamping is enabled
-            TimestampCapturingTSAClient tsaClient = null;
-            String timestampInfo = null;
+        } catch (Exception e) {
+            logger.error("Error signing PDF for signer: {}", request.getSignerName(), e);
+            throw new RuntimeException("Failed to sign PDF: " + e.getMessage(), e);
+        }
+    }
+
+    public boolean isLargeDocument(long size) {
+        return lazyThresholdBytes > 0 && size >= lazyThresholdBytes;
+    }
+
+    /**
+     * Lazy variant for documents above {@code firmador.signature.lazy-threshold-mb}.
+     * The reader maps {@code input} and resolves objects through the xref table
+     * on demand, and the signature goes into an incremental update, so only the
+     * trailer, catalog, AcroForm and target page are parsed; every other object
+     * is carried over as the original bytes. iText's working copy is kept in a
+     * temp file next to {@code output} instead of the heap.
+     */
+    public void signPdf(Path input, Path output, SignatureRequest request) {
+        SigningKey signingKey;
+        try {
+            signingKey = loadSigningKey(request.getCertificateData(), request.getCertificatePassword());
+        } catch (Exception e) {
+            logger.error("Error loading certificate for signer: {}", request.getSignerName(), e);
+            throw new RuntimeException("Failed to sign PDF: " + e.getMessage(), e);
+        }
+        signPdf(input, output, request, signingKey);
+    }
+
+    /** Lazy variant with a key unlocked beforehand, see {@link #signPdf(byte[], SignatureRequest, SigningKey)}. */
+    public void signPdf(Path input, Path output, SignatureRequest request, SigningKey signingKey) {
+        PdfReader reader = null;
+        try (OutputStream outputStream = Files.newOutputStream(output)) {
+            logger.info("Starting lazy PDF signing process for signer: {} ({} bytes)",
+                       request.getSignerName(), Files.size(input));
             
-            if (Boolean.TRUE.equals(request.getEnableTimestamp())) {
-                logger.info("Timestamping requested for server: {} ({})", 
-                           request.getTimestampServerUrl(), 
-                           getTsaServerDisplayName(request.getTimestampServerUrl()));
-                ITSAClient baseTsaClient = createTSAClientWithFallback(request.getTimestampServerUrl());
-                if (baseTsaClient != null) {
-                    tsaClient = new TimestampCapturingTSAClient(baseTsaClient);
-                    logger.info("Timestamping enabled with fallback server support");
-                } else {
-                    logger.warn("Failed to create TSA client with any available server, signing without timestamp");
-                }
-            } else {
-                logger.info("Timestamping disabled by user request");
+            reader = new PdfReader(input.toString());
+            PdfSigner signer = new PdfSigner(reader, outputStream, output.toAbsolutePath().getParent().toString(),
+                new StampingProperties().useAppendMode());
+            sign(signer, request, signingKey);
+        } catch (Exception e) {
+            closeQuietly(reader);
+            logger.error("Error signing PDF for signer: {}", request.getSignerName(), e);
+            throw new RuntimeException("Failed to sign PDF: " + e.getMessage(), e);
+        }
+        
+        if (isBatchTimestamp(request)) {
+            try {
+                attachEvidenceRecord(output, request.getTimestampServerUrl());
+            } catch (Exception e) {
+                logger.error("Error signing PDF for signer: {}", request.getSignerName(), e);
+                throw new RuntimeException("Failed to sign PDF: " + e.getMessage(), e);
             }
-            
-            // If timestamp is enabled, pre-fetch timestamp info for signature appearance
-            if (tsaClient != null) {
-                try {
-                    // Create a dummy message to get timestamp info
-                    byte[] dummyMessage = "dummy".getBytes();
-                    MessageDigest digest = MessageDigest.getInstance("SHA-256");
-                    byte[] hash = digest.digest(dummyMessage);
-                    
-                    // Get timestamp token to extract the actual timestamp
-                    tsaClient.getTimeStampToken(hash);
-                    timestampInfo = tsaClient.getTimestampInfo();
-                    
-                    logger.info("Pre-fetched timestamp info for signature appearance: {}", timestampInfo);
-                } catch (Exception e) {
-                    logger.warn("Could not pre-fetch timestamp info: {}", e.getMessage());
-                    timestampInfo = "Incluido (verificar con servidor TSA)";
-                }
+        }
+    }
+
+    private void sign(PdfSigner signer, SignatureRequest request, SigningKey signingKey) throws Exception {
+        PrivateKey privateKey = signingKey.getPrivateKey();
+        Certificate[] certificateChain = signingKey.getCertificateChain();
+        
+        logger.info("Certificate loaded successfully for alias: {}", signingKey.getAlias());
+        
+        // Create external signature container with the provider measured fastest at startup
+        IExternalSignature externalSignature = signatureProviderSelector.createSignature(privateKey);
+        logger.info("Signing with provider: {}", signatureProviderSelector.providerFor(privateKey));
+        
+        // Create TSA client if timestamping is enabled
+        TimestampCapturingTSAClient tsaClient = null;
+        String timestampInfo = null;
+        
+        if (isBatchTimestamp(request)) {
+            // The token is obtained after signing, shared with the rest of the batch
+            logger.info("Batch timestamping requested for server: {}", request.getTimestampServerUrl());
+            timestampInfo = "Por lotes (registro de evidencia adjunto)";
+        } else if (Boolean.TRUE.equals(request.getEnableTimestamp())) {
+            logger.info("Timestamping requested for server: {} ({})", 
+                       request.getTimestampServerUrl(), 
+                       getTsaServerDisplayName(request.getTimestampServerUrl()));
+            ITSAClient baseTsaClient = createTSAClientWithFallback(request.getTimestampServerUrl());
+            if (baseTsaClient != null) {
+                tsaClient = new TimestampCapturingTSAClient(baseTsaClient);
+                logger.info("Timestamping enabled with fallback server support");
+            } else {
+                logger.warn("Failed to create TSA client with any available server, signing without timestamp");
             }
-            
-            // Configure signature appearance with actual or placeholder timestamp info
-            configureSignatureAppearance(signer, request, timestampInfo);
-            
-            // Sign the document with proper parameters and error handling for TSA
+        } else {
+            logger.info("Timestamping disabled by user request");
+        }
+        
+        // If timestamp is enabled, pre-fetch timestamp info for signature appearance
+        if (tsaClient != null) {
             try {
+                // Create a dummy message to get timestamp info
+                byte[] dummyMessage = "dummy".getBytes();
+                MessageDigest digest = MessageDigest.getInstance("SHA-256");
+                byte[] hash = digest.digest(dummyMessage);
+                
+                // Get timestamp token to extract the actual timestamp
+                tsaClient.getTimeStampToken(hash);
+                timestampInfo = tsaClient.getTimestampInfo();
+                
+                logger.info("Pre-fetched timestamp info for signature appearance: {}", timestampInfo);
+            } catch (Exception e) {
+                logger.warn("Could not pre-fetch timestamp info: {}", e.getMessage());
+                timestampInfo = "Incluido (verificar con servidor TSA)";
+            }
+        }
+        
+        // Configure signature appearance with actual or placeholder timestamp info
+        configureSignatureAppearance(signer, request, timestampInfo);
+        
+        // Sign the document with proper parameters and error handling for TSA
+        try {
+            signer.signDetached(
+                signatureProviderSelector.createDigest(),
+                externalSignature,
+                certificateChain,
+                null,  // CRL clients
+                null,  // OCSP client
+                tsaClient,
+                0,     // Estimated size
+                PdfSigner.CryptoStandard.CMS
+            );
+        } catch (Exception signingException) {
+            // If signing with timestamp fails, try without timestamp
+            if (tsaClient != null) {
+                logger.warn("Signing with timestamp failed, retrying without timestamp: {}", signingException.getMessage());
+                tsaClient = null;
+                
+                // Reconfigure appearance without timestamp
+                configureSignatureAppearance(signer, request, null);
+                
+                // Retry signing without timestamp
                 signer.signDetached(
-                    new BouncyCastleDigest(),
+                    signatureProviderSelector.createDigest(),
                     externalSignature,
                     certificateChain,
                     null,  // CRL clients
                     null,  // OCSP client
-                    tsaClient,
+                    null,  // No TSA client
                     0,     // Estimated size
                     PdfSigner.CryptoStandard.CMS
                 );
-            } catch (Exception signingException) {
-                // If signing with timestamp fails, try without timestamp
-                if (tsaClient != null) {
-                    logger.warn("Signing with timestamp failed, retrying without timestamp: {}", signingException.getMessage());
-                    tsaClient = null;
-                    
-                    // Reconfigure appearance without timestamp
-                    configureSignatureAppearance(signer, request, null);
-                    
-                    // Retry signing without timestamp
-                    signer.signDetached(
-                        new BouncyCastleDigest(),
-                        externalSignature,
-                        certificateChain,
-                        null,  // CRL clients
-                        null,  // OCSP client
-                        null,  // No TSA client
-                        0,     // Estimated size
-                        PdfSigner.CryptoStandard.CMS
-                    );
-                } else {
-                    // If it fails without timestamp, re-throw the exception
-                    throw signingException;
-                }
-            }
-            
-            // Log detailed signing success information and capture timestamp info
-            if (tsaClient != null) {
-                timestampInfo = tsaClient.getTimestampInfo();
-                logger.info("PDF signed successfully with timestamp. TSA Server: {} ({})", 
-                           request.getTimestampServerUrl(),
-                           getTsaServerDisplayName(request.getTimestampServerUrl()));
-                logger.info("Timestamp generated: {}", timestampInfo != null ? timestampInfo : "Unknown");
             } else {
-                logger.info("PDF signed successfully without timestamp");
+                // If it fails without timestamp, re-throw the exception
+                throw signingException;
             }
-            
-            return outputStream.toByteArray();
-            
+        }
+        
+        // Log detailed signing success information and capture timestamp info
+        if (tsaClient != null) {
+            timestampInfo = tsaClient.getTimestampInfo();
+            logger.info("PDF signed successfully with timestamp. TSA Server: {} ({})", 
+                       request.getTimestampServerUrl(),
+                       getTsaServerDisplayName(request.getTimestampServerUrl()));
+            logger.info("Timestamp generated: {}", timestampInfo != null ? timestampInfo : "Unknown");
+        } else {
+            logger.info("PDF signed successfully without timestamp");
+        }
+    }
+
+    private static boolean isBatchTimestamp(SignatureRequest request) {
+        return Boolean.TRUE.equals(request.getEnableTimestamp()) &&
+            Boolean.TRUE.equals(request.getBatchTimestamp());
+    }
+
+    private static void closeQuietly(PdfReader reader) {
+        if (reader == null) {
+            return;
+        }
+        try {
+            reader.close();
         } catch (Exception e) {
-            logger.error("Error signing PDF for signer: {}", request.getSignerName(), e);
-            throw new RuntimeException("Failed to sign PDF: " + e.getMessage(), e);
+            logger.debug("Could not close PDF reader: {}", e.getMessage());
+        }
+    }
+
+    /**
+     * Timestamps the signed revision through the batch aggregator and embeds
+     * the resulting evidence record in an incremental update, leaving the
+     * signed bytes untouched. The appearance already announces the evidence
+     * record, so a failure here fails the whole request.
+     */
+    private byte[] attachEvidenceRecord(byte[] signedPdf, String tsaUrl) throws Exception {
+        byte[] hash = MessageDigest.getInstance("SHA-256").digest(signedPdf);
+        byte[] evidenceRecord = requestEvidenceRecord(hash, tsaUrl);
+
+        ByteArrayOutputStream outputStream = new ByteArrayOutputStream(signedPdf.length + evidenceRecord.length + 2048);
+        try (PdfDocument pdfDocument = new PdfDocument(
+                new PdfReader(new ByteArrayInputStream(signedPdf)),
+                new PdfWriter(outputStream),
+                new StampingProperties().useAppendMode())) {
+            embedEvidenceRecord(pdfDocument, evidenceRecord, signedPdf.length);
         }
+        logger.info("Attached evidence record ({} bytes) to signed PDF", evidenceRecord.length);
+        return outputStream.toByteArray();
+    }
+
+    /**
+     * File-backed counterpart of {@link #attachEvidenceRecord(byte[], String)}:
+     * the hash is streamed and {@code signedPdf} is replaced only once the
+     * update has been written completely.
+     */
+    private void attachEvidenceRecord(Path signedPdf, String tsaUrl) throws Exception {
+        MessageDigest digest = MessageDigest.getInstance("SHA-256");
+        try (InputStream in = new DigestInputStream(Files.newInputStream(signedPdf), digest)) {
+            in.transferTo(OutputStream.nullOutputStream());
+        }
+        long signedLength = Files.size(signedPdf);
+        byte[] evidenceRecord = requestEvidenceRecord(digest.digest(), tsaUrl);
+
+        Path staging = Files.createTempFile(signedPdf.toAbsolutePath().getParent(), "evidence", ".tmp");
+        try {
+            try (PdfDocument pdfDocument = new PdfDocument(
+                    new PdfReader(signedPdf.toString()),
+                    new PdfWriter(staging.toString()),
+                    new StampingProperties().useAppendMode())) {
+                embedEvidenceRecord(pdfDocument, evidenceRecord, signedLength);
+            }
+            Files.move(staging, signedPdf, StandardCopyOption.REPLACE_EXISTING);
+            logger.info("Attached evidence record ({} bytes) to signed PDF", evidenceRecord.length);
+        } finally {
+            Files.deleteIfExists(staging);
+        }
+    }
+
+    private byte[] requestEvidenceRecord(byte[] hash, String tsaUrl) throws Exception {
+        try {
+            return batchTimestampService.timestamp(hash, tsaUrl);
+        } catch (Exception e) {
+            logger.error("Batch timestamp failed: {}", e.getMessage());
+            throw new IllegalStateException("Batch timestamp failed: " + e.getMessage(), e);
+        }
+    }
+
+    private void embedEvidenceRecord(PdfDocument pdfDocument, byte[] evidenceRecord, long signedLength) {
+        PdfFileSpec fileSpec = PdfFileSpec.createEmbeddedFileSpec(
+            pdfDocument,
+            evidenceRecord,
+            "Registro de evidencia RFC 4998 de la revisión firmada (" + signedLength + " bytes)",
+            EVIDENCE_RECORD_FILENAME,
+            null,
+            null,
+            PdfName.Supplement);
+        pdfDocument.addFileAttachment(EVIDENCE_RECORD_FILENAME, fileSpec);
     }
 
     private KeyStore loadKeyStore(byte[] certificateData, String password) throws Exception {
@@ -1,48 +1,190 @@
 package com.firmador.backend.service;
 
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.scheduling.annotation.Scheduled;
 import org.springframework.stereotype.Service;
-import java.util.concurrent.ConcurrentHashMap;
-import java.util.Map;
 
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.*;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.time.Duration;
+import java.time.Instant;
+import java.util.Optional;
+import java.util.concurrent.TimeUnit;
+import java.util.stream.Stream;
+
+/**
+ * Signed documents kept on disk under {@code firmador.storage.path} so they
+ * can be downloaded again by id from any instance sharing that directory.
+ *
+ * When {@code firmador.storage.accel-redirect.enabled} is set, downloads of
+ * files under the storage path are answered with an {@code X-Accel-Redirect}
+ * header and nginx serves the bytes itself (sendfile, ranges, conditional
+ * requests) from an internal location that aliases the same directory.
+ */
 @Service
 public class DocumentStorageService {
-    
-    // Almacenamiento en memoria (para desarrollo - en producción usar S3, etc.)
-    private final Map<String, StoredDocument> documentStorage = new ConcurrentHashMap<>();
-    
-    public void storeDocument(String documentId, byte[] data, String filename, String contentType) {
-        StoredDocument storedDoc = new StoredDocument(data, filename, contentType, System.currentTimeMillis());
-        documentStorage.put(documentId, storedDoc);
-    }
-    
+
+    private static final Logger logger = LoggerFactory.getLogger(DocumentStorageService.class);
+
+    private static final String DOCUMENTS = "documents";
+    private static final String DOCUMENT_SUFFIX = ".pdf";
+    private static final String FILENAME_SUFFIX = ".name";
+
+    private final Path root;
+    private final Path documentsDir;
+    private final Duration retention;
+    private final boolean accelRedirectEnabled;
+    private final String accelRedirectPrefix;
+
+    public DocumentStorageService(@Value("${firmador.storage.path:${java.io.tmpdir}/firmador-storage}") String storagePath,
+                                  @Value("${firmador.storage.retention-minutes:60}") long retentionMinutes,
+                                  @Value("${firmador.storage.accel-redirect.enabled:false}") boolean accelRedirectEnabled,
+                                  @Value("${firmador.storage.accel-redirect.prefix:/protected-storage/}") String accelRedirectPrefix)
+            throws IOException {
+        this.root = Paths.get(storagePath).toAbsolutePath().normalize();
+        this.documentsDir = root.resolve(DOCUMENTS);
+        this.retention = Duration.ofMinutes(retentionMinutes);
+        this.accelRedirectEnabled = accelRedirectEnabled;
+        this.accelRedirectPrefix = accelRedirectPrefix.endsWith("/") ? accelRedirectPrefix : accelRedirectPrefix + "/";
+        Files.createDirectories(documentsDir);
+    }
+
+    public void storeDocument(String documentId, byte[] data, String filename, String contentType) throws IOException {
+        // Written under a temporary name so a concurrent download never sees a partial file
+        Path staging = createStagingFile(documentId);
+        Files.write(staging, data);
+        storeDocument(documentId, staging, filename);
+    }
+
+    /**
+     * Temporary file inside the storage directory, so a result written there
+     * can be published with an atomic rename. Leftovers are purged with the
+     * expired documents.
+     */
+    public Path createStagingFile(String documentId) throws IOException {
+        requireValidId(documentId);
+        return Files.createTempFile(documentsDir, documentId, ".tmp");
+    }
+
+    /** Publishes a file obtained from {@link #createStagingFile(String)} under {@code documentId}. */
+    public void storeDocument(String documentId, Path staging, String filename) throws IOException {
+        requireValidId(documentId);
+        makeReadableByProxy(staging);
+        Files.write(documentsDir.resolve(documentId + FILENAME_SUFFIX), filename.getBytes(StandardCharsets.UTF_8));
+        Files.move(staging, documentsDir.resolve(documentId + DOCUMENT_SUFFIX),
+            StandardCopyOption.ATOMIC_MOVE, StandardCopyOption.REPLACE_EXISTING);
+    }
+
     public StoredDocument getDocument(String documentId) {
-        return documentStorage.get(documentId);
+        if (!isValidId(documentId)) {
+            return null;
+        }
+        Path path = documentsDir.resolve(documentId + DOCUMENT_SUFFIX);
+        try {
+            Path filenamePath = documentsDir.resolve(documentId + FILENAME_SUFFIX);
+            String filename = Files.exists(filenamePath) ?
+                Files.readString(filenamePath) : documentId + DOCUMENT_SUFFIX;
+            return new StoredDocument(path, filename, "application/pdf",
+                Files.getLastModifiedTime(path).toMillis(), Files.size(path));
+        } catch (NoSuchFileException e) {
+            return null;
+        } catch (IOException e) {
+            logger.warn("Could not read stored document {}: {}", documentId, e.getMessage());
+            return null;
+        }
     }
-    
+
     public boolean documentExists(String documentId) {
-        return documentStorage.containsKey(documentId);
+        return isValidId(documentId) && Files.exists(documentsDir.resolve(documentId + DOCUMENT_SUFFIX));
     }
-    
+
     public void removeDocument(String documentId) {
-        documentStorage.remove(documentId);
+        if (!isValidId(documentId)) {
+            return;
+        }
+        try {
+            Files.deleteIfExists(documentsDir.resolve(documentId + DOCUMENT_SUFFIX));
+            Files.deleteIfExists(documentsDir.resolve(documentId + FILENAME_SUFFIX));
+        } catch (IOException e) {
+            logger.warn("Could not remove stored document {}: {}", documentId, e.getMessage());
+        }
     }
-    
+
+    public boolean isAccelRedirectEnabled() {
+        return accelRedirectEnabled;
+    }
+
+    /**
+     * Internal nginx URI for {@code file}, or empty if redirects are disabled
+     * or the file lives outside the storage path nginx can see.
+     */
+    public Optional<String> accelRedirectUri(Path file) {
+        if (!accelRedirectEnabled) {
+            return Optional.empty();
+        }
+        Path normalized = file.toAbsolutePath().normalize();
+        if (!normalized.startsWith(root)) {
+            return Optional.empty();
+        }
+        return Optional.of(accelRedirectPrefix + root.relativize(normalized).toString().replace('\\', '/'));
+    }
+
+    @Scheduled(fixedDelay = 5, timeUnit = TimeUnit.MINUTES)
+    public void purgeExpiredDocuments() {
+        Instant cutoff = Instant.now().minus(retention);
+        try (Stream<Path> files = Files.list(documentsDir)) {
+            for (Path file : files.toList()) {
+                if (Files.getLastModifiedTime(file).toInstant().isBefore(cutoff)) {
+                    Files.deleteIfExists(file);
+                }
+            }
+        } catch (IOException e) {
+            logger.warn("Could not purge stored documents: {}", e.getMessage());
+        }
+    }
+
+    // Temp files are created owner-only, but nginx reads them as another user
+    private static void makeReadableByProxy(Path path) throws IOException {
+        try {
+            Files.setPosixFilePermissions(path, PosixFilePermissions.fromString("rw-r--r--"));
+        } catch (UnsupportedOperationException e) {
+            // Non-POSIX file system: keep the default permissions
+        }
+    }
+
+    private static boolean isValidId(String documentId) {
+        return documentId != null && documentId.matches("[A-Za-z0-9-]{1,64}");
+    }
+
+    private static void requireValidId(String documentId) {
+        if (!isValidId(documentId)) {
+            throw new IllegalArgumentException("Invalid document id: " + documentId);
+        }
+    }
+
     public static class StoredDocument {
-        private final byte[] data;
+        private final Path path;
         private final String filename;
         private final String contentType;
         private final long timestamp;
-        
-        public StoredDocument(byte[] data, String filename, String contentType, long timestamp) {
-            this.data = data;
+        private final long size;
+
+        public StoredDocument(Path path, String filename, String contentType, long timestamp, long size) {
+            this.path = path;
             this.filename = filename;
             this.contentType = contentType;
             this.timestamp = timestamp;
+            this.size = size;
         }
-        
-        public byte[] getData() { return data; }
+
+        public Path getPath() { return path; }
         public String getFilename() { return filename; }
         public String getContentType() { return contentType; }
         public long getTimestamp() { return timestamp; }
+        public long getSize() { return size; }
     }
-} 
\ No newline at end of file
+}
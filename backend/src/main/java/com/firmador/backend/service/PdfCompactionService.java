@@ -0,0 +1,218 @@
+package com.firmador.backend.service;
+
+import com.itextpdf.kernel.pdf.*;
+import com.itextpdf.signatures.SignatureUtil;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.stereotype.Service;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.*;
+
+/**
+ * Optional full rewrite of a document before it is signed.
+ *
+ * The rewrite packs objects into object streams with an xref stream, collapses
+ * byte-identical streams (typically images repeated on every page of a scan)
+ * into a single object and recompresses plain Flate streams at the best
+ * level. Since it renumbers and rewrites every object it would invalidate any
+ * existing signature, so signed documents are refused.
+ */
+@Service
+public class PdfCompactionService {
+
+    private static final Logger logger = LoggerFactory.getLogger(PdfCompactionService.class);
+
+    public static class CompactionResult {
+        private final byte[] data;
+        private final long originalSize;
+        private final long compactedSize;
+        private final int deduplicatedStreams;
+        private final long elapsedMillis;
+
+        public CompactionResult(byte[] data, long originalSize, long compactedSize,
+                                int deduplicatedStreams, long elapsedMillis) {
+            this.data = data;
+            this.originalSize = originalSize;
+            this.compactedSize = compactedSize;
+            this.deduplicatedStreams = deduplicatedStreams;
+            this.elapsedMillis = elapsedMillis;
+        }
+
+        public byte[] getData() { return data; }
+        public long getOriginalSize() { return originalSize; }
+        public long getCompactedSize() { return compactedSize; }
+        public int getDeduplicatedStreams() { return deduplicatedStreams; }
+        public long getElapsedMillis() { return elapsedMillis; }
+    }
+
+    public static class SignedDocumentException extends IllegalStateException {
+        public SignedDocumentException(String message) {
+            super(message);
+        }
+    }
+
+    public CompactionResult compact(byte[] pdfBytes) throws IOException {
+        long start = System.nanoTime();
+        ByteArrayOutputStream outputStream = new ByteArrayOutputStream(pdfBytes.length);
+        WriterProperties writerProperties = new WriterProperties()
+            .setFullCompressionMode(true)
+            .setCompressionLevel(CompressionConstants.BEST_COMPRESSION);
+
+        // Checked read-only: once a writer is attached, closing the document
+        // (even on an exception) writes out the whole rewrite
+        try (PdfDocument probe = new PdfDocument(new PdfReader(new ByteArrayInputStream(pdfBytes)))) {
+            if (!new SignatureUtil(probe).getSignatureNames().isEmpty()) {
+                throw new SignedDocumentException(
+                    "Document already carries signatures that a rewrite would invalidate");
+            }
+        }
+
+        int deduplicated;
+        try (PdfDocument pdfDocument = new PdfDocument(
+                new PdfReader(new ByteArrayInputStream(pdfBytes)),
+                new PdfWriter(outputStream, writerProperties))) {
+            deduplicated = deduplicateStreams(pdfDocument);
+            recompressFlateStreams(pdfDocument);
+        }
+
+        byte[] compacted = outputStream.toByteArray();
+        long elapsedMillis = (System.nanoTime() - start) / 1_000_000;
+        logger.info("Compacted PDF from {} to {} bytes ({} duplicate streams) in {} ms",
+            pdfBytes.length, compacted.length, deduplicated, elapsedMillis);
+
+        // A rewrite of an already compact file can come out slightly larger
+        if (compacted.length >= pdfBytes.length) {
+            return new CompactionResult(pdfBytes, pdfBytes.length, pdfBytes.length, 0, elapsedMillis);
+        }
+        return new CompactionResult(compacted, pdfBytes.length, compacted.length, deduplicated, elapsedMillis);
+    }
+
+    /**
+     * Points every reference to a duplicate stream at its first occurrence and
+     * frees the duplicates so they are not written.
+     */
+    private int deduplicateStreams(PdfDocument pdfDocument) {
+        Map<String, PdfIndirectReference> canonical = new HashMap<>();
+        Map<Integer, PdfIndirectReference> replacements = new HashMap<>();
+
+        int objectCount = pdfDocument.getNumberOfPdfObjects();
+        for (int i = 1; i < objectCount; i++) {
+            PdfObject object = pdfDocument.getPdfObject(i);
+            if (!(object instanceof PdfStream) || object.getIndirectReference() == null) {
+                continue;
+            }
+            PdfStream stream = (PdfStream) object;
+            // Cross-reference and object streams are regenerated by the writer
+            if (PdfName.XRef.equals(stream.getAsName(PdfName.Type)) ||
+                PdfName.ObjStm.equals(stream.getAsName(PdfName.Type))) {
+                continue;
+            }
+            String key = streamKey(stream);
+            PdfIndirectReference first = canonical.putIfAbsent(key, stream.getIndirectReference());
+            if (first != null) {
+                replacements.put(stream.getIndirectReference().getObjNumber(), first);
+            }
+        }
+
+        if (replacements.isEmpty()) {
+            return 0;
+        }
+
+        Set<PdfObject> visited = Collections.newSetFromMap(new IdentityHashMap<>());
+        for (int i = 1; i < objectCount; i++) {
+            PdfObject object = pdfDocument.getPdfObject(i);
+            if (object != null) {
+                replaceReferences(object, replacements, visited);
+            }
+        }
+        replaceReferences(pdfDocument.getTrailer(), replacements, visited);
+
+        for (Integer objectNumber : replacements.keySet()) {
+            pdfDocument.getPdfObject(objectNumber).getIndirectReference().setFree();
+        }
+        return replacements.size();
+    }
+
+    private void replaceReferences(PdfObject object, Map<Integer, PdfIndirectReference> replacements,
+                                   Set<PdfObject> visited) {
+        if (!visited.add(object)) {
+            return;
+        }
+        if (object instanceof PdfDictionary) {
+            PdfDictionary dictionary = (PdfDictionary) object;
+            for (PdfName key : new ArrayList<>(dictionary.keySet())) {
+                PdfObject value = dictionary.get(key, false);
+                PdfIndirectReference replacement = replacementFor(value, replacements);
+                if (replacement != null) {
+                    dictionary.put(key, replacement);
+                } else if (value != null && !value.isIndirectReference()) {
+                    replaceReferences(value, replacements, visited);
+                }
+            }
+        } else if (object instanceof PdfArray) {
+            PdfArray array = (PdfArray) object;
+            for (int i = 0; i < array.size(); i++) {
+                PdfObject value = array.get(i, false);
+                PdfIndirectReference replacement = replacementFor(value, replacements);
+                if (replacement != null) {
+                    array.set(i, replacement);
+                } else if (value != null && !value.isIndirectReference()) {
+                    replaceReferences(value, replacements, visited);
+                }
+            }
+        }
+    }
+
+    private PdfIndirectReference replacementFor(PdfObject value, Map<Integer, PdfIndirectReference> replacements) {
+        if (value == null || !value.isIndirectReference()) {
+            return null;
+        }
+        return replacements.get(((PdfIndirectReference) value).getObjNumber());
+    }
+
+    /**
+     * Inflates streams whose only filter is FlateDecode without predictors and
+     * lets the writer deflate them again at the best compression level.
+     */
+    private void recompressFlateStreams(PdfDocument pdfDocument) {
+        int objectCount = pdfDocument.getNumberOfPdfObjects();
+        for (int i = 1; i < objectCount; i++) {
+            PdfObject object = pdfDocument.getPdfObject(i);
+            if (!(object instanceof PdfStream) || object.getIndirectReference() == null ||
+                object.getIndirectReference().isFree()) {
+                continue;
+            }
+            PdfStream stream = (PdfStream) object;
+            if (!PdfName.FlateDecode.equals(stream.get(PdfName.Filter)) || stream.containsKey(PdfName.DecodeParms)) {
+                continue;
+            }
+            byte[] decoded = stream.getBytes(true);
+            stream.setData(decoded);
+            stream.remove(PdfName.Filter);
+            stream.setCompressionLevel(CompressionConstants.BEST_COMPRESSION);
+        }
+    }
+
+    private String streamKey(PdfStream stream) {
+        StringBuilder key = new StringBuilder();
+        List<PdfName> keys = new ArrayList<>(stream.keySet());
+        Collections.sort(keys);
+        for (PdfName name : keys) {
+            if (!PdfName.Length.equals(name)) {
+                key.append(name).append('=').append(stream.get(name, false)).append(';');
+            }
+        }
+        try {
+            MessageDigest digest = MessageDigest.getInstance("SHA-256");
+            key.append(Base64.getEncoder().encodeToString(digest.digest(stream.getBytes(false))));
+        } catch (NoSuchAlgorithmException e) {
+            throw new IllegalStateException(e);
+        }
+        return key.toString();
+    }
+}
@@ -0,0 +1,674 @@
+package com.firmador.backend.service;
+
+import com.firmador.backend.dto.PreflightResult;
+import com.itextpdf.io.source.IRandomAccessSource;
+import com.itextpdf.io.source.RandomAccessSourceFactory;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.stereotype.Service;
+
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Path;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.Map;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+import java.util.zip.DataFormatException;
+import java.util.zip.Inflater;
+
+/**
+ * Cheap structural checks run before a document reaches PdfReader/PdfSigner.
+ *
+ * Only the header, the tail (startxref/trailer) and the handful of objects
+ * reachable from the trailer (catalog, page tree root, AcroForm) are read, so
+ * the cost does not grow with the size of the document, only with the amount
+ * of junk after the last %%EOF. Xref streams and the object streams holding
+ * those objects are inflated, up to a fixed size.
+ */
+@Service
+public class PdfPreflightService {
+
+    private static final Logger logger = LoggerFactory.getLogger(PdfPreflightService.class);
+
+    private static final int HEAD_WINDOW = 1024;
+    private static final int TAIL_WINDOW = 8192;
+    private static final String EOF_MARKER = "%%EOF";
+    private static final int OBJECT_WINDOW = 4096;
+    private static final int LINE_WINDOW = 64;
+    private static final int XREF_ENTRY_LENGTH = 20;
+    private static final int MAX_XREF_SECTIONS = 32;
+    private static final int MAX_SUBSECTIONS = 4096;
+    private static final int MAX_STREAM_BYTES = 1 << 20;
+    private static final int MAX_INFLATED_BYTES = 8 << 20;
+
+    private static final Pattern HEADER = Pattern.compile("%PDF-(\\d\\.\\d)");
+    private static final Pattern STARTXREF = Pattern.compile("startxref\\s+(\\d+)");
+    private static final Pattern SUBSECTION = Pattern.compile("(\\d+)\\s+(\\d+)[ \\t]*(?:\\r\\n|\\r|\\n)");
+    private static final Pattern OBJECT_HEADER = Pattern.compile("\\s*(\\d+)\\s+(\\d+)\\s+obj\\b");
+    private static final Pattern PREV = Pattern.compile("/Prev\\s+(\\d+)");
+    private static final Pattern ROOT = Pattern.compile("/Root\\s+(\\d+)\\s+\\d+\\s+R");
+    private static final Pattern PAGES = Pattern.compile("/Pages\\s+(\\d+)\\s+\\d+\\s+R");
+    private static final Pattern COUNT = Pattern.compile("/Count\\s+(\\d+)");
+    private static final Pattern LINEARIZED_PAGES = Pattern.compile("/N\\s+(\\d+)");
+    private static final Pattern ACROFORM_REF = Pattern.compile("/AcroForm\\s+(\\d+)\\s+\\d+\\s+R");
+    private static final Pattern SIG_FLAGS = Pattern.compile("/SigFlags\\s+(\\d+)");
+    private static final Pattern ENCRYPT = Pattern.compile("/Encrypt\\b");
+    private static final Pattern XREF_TYPE = Pattern.compile("/Type\\s*/XRef\\b");
+    private static final Pattern XREF_STM = Pattern.compile("/XRefStm\\s+(\\d+)");
+    private static final Pattern WIDTHS = Pattern.compile("/W\\s*\\[\\s*(\\d+)\\s+(\\d+)\\s+(\\d+)\\s*\\]");
+    private static final Pattern INDEX = Pattern.compile("/Index\\s*\\[([\\d\\s]*)\\]");
+    private static final Pattern SIZE = Pattern.compile("/Size\\s+(\\d+)");
+    private static final Pattern LENGTH = Pattern.compile("/Length\\s+(\\d+)(\\s+\\d+\\s+R)?");
+    private static final Pattern FILTER = Pattern.compile("/Filter\\s*(\\[[^\\]]*\\]|/[A-Za-z0-9]+)");
+    private static final Pattern PREDICTOR = Pattern.compile("/Predictor\\s+(\\d+)");
+    private static final Pattern COLUMNS = Pattern.compile("/Columns\\s+(\\d+)");
+    private static final Pattern OBJECT_COUNT = Pattern.compile("/N\\s+(\\d+)");
+    private static final Pattern FIRST = Pattern.compile("/First\\s+(\\d+)");
+    private static final Pattern INTEGER = Pattern.compile("\\d+");
+
+    public PreflightResult scan(byte[] pdfBytes, int signaturePage) {
+        return scan(new RandomAccessSourceFactory().createSource(pdfBytes), signaturePage);
+    }
+
+    /** Scans a file through a mapped source, without reading it into the heap. */
+    public PreflightResult scan(Path pdfFile, int signaturePage) throws IOException {
+        IRandomAccessSource source = new RandomAccessSourceFactory().createBestSource(pdfFile.toString());
+        try {
+            return scan(source, signaturePage);
+        } finally {
+            source.close();
+        }
+    }
+
+    public PreflightResult scan(IRandomAccessSource source, int signaturePage) {
+        long start = System.nanoTime();
+        PreflightResult result;
+        try {
+            result = inspect(source, signaturePage);
+        } catch (IOException | RuntimeException e) {
+            logger.warn("Preflight could not read document structure: {}", e.getMessage());
+            result = new PreflightResult(PreflightResult.Status.BROKEN_XREF,
+                "Document structure could not be read: " + e.getMessage());
+        }
+        result.setFileSize(source.length());
+        result.setElapsedMillis((System.nanoTime() - start) / 1_000_000);
+        logger.debug("Preflight finished in {} ms with status {}", result.getElapsedMillis(), result.getStatus());
+        return result;
+    }
+
+    private PreflightResult inspect(IRandomAccessSource source, int signaturePage) throws IOException {
+        long length = source.length();
+
+        // Header: readers accept junk before %PDF- within the first kilobyte,
+        // in which case every offset in the file is relative to the header.
+        String head = read(source, 0, HEAD_WINDOW);
+        Matcher header = HEADER.matcher(head);
+        if (!header.find()) {
+            return new PreflightResult(PreflightResult.Status.NOT_PDF, "File is not a PDF document");
+        }
+        long base = header.start();
+
+        // Tail: the last startxref must be followed by %%EOF. Like iText, the
+        // marker is searched backwards, so trailing junk is tolerated.
+        long eofPosition = findLast(source, EOF_MARKER, length);
+        if (eofPosition < 0) {
+            return new PreflightResult(PreflightResult.Status.TRUNCATED,
+                "PDF is truncated: missing startxref or %%EOF marker");
+        }
+        long tailEnd = eofPosition + EOF_MARKER.length();
+        long tailStart = Math.max(0, tailEnd - TAIL_WINDOW);
+        String tail = read(source, tailStart, (int) (tailEnd - tailStart));
+        int eof = tail.lastIndexOf(EOF_MARKER);
+        int startxrefIndex = eof >= 0 ? tail.lastIndexOf("startxref", eof) : -1;
+        if (startxrefIndex < 0) {
+            return new PreflightResult(PreflightResult.Status.TRUNCATED,
+                "PDF is truncated: missing startxref or %%EOF marker");
+        }
+        Matcher startxref = STARTXREF.matcher(tail);
+        if (!startxref.find(startxrefIndex)) {
+            return new PreflightResult(PreflightResult.Status.TRUNCATED, "PDF is truncated: malformed startxref");
+        }
+        long xrefPosition = base + Long.parseLong(startxref.group(1));
+        if (xrefPosition >= length) {
+            return new PreflightResult(PreflightResult.Status.BROKEN_XREF,
+                "startxref points past the end of the file");
+        }
+
+        Xref xref = openXref(source, xrefPosition, base);
+        if (xref == null) {
+            return new PreflightResult(PreflightResult.Status.BROKEN_XREF,
+                "startxref does not point at a readable cross-reference table or stream");
+        }
+
+        PreflightResult result = new PreflightResult(PreflightResult.Status.OK, "Document passed preflight");
+        result.setPdfVersion(header.group(1));
+
+        if (ENCRYPT.matcher(xref.trailer).find()) {
+            result.setStatus(PreflightResult.Status.ENCRYPTED);
+            result.setMessage("Encrypted PDF documents cannot be signed");
+            result.setEncrypted(true);
+            return result;
+        }
+
+        String catalog = null;
+        Matcher root = ROOT.matcher(xref.trailer);
+        if (root.find()) {
+            catalog = resolveObject(source, xref, Integer.parseInt(root.group(1)));
+        }
+
+        result.setHasExistingSignatures(tail.contains("/ByteRange") || hasSignatureFlag(source, xref, catalog));
+        result.setPageCount(findPageCount(source, xref, head, catalog));
+
+        if (signaturePage < 1 || (result.getPageCount() != null && signaturePage > result.getPageCount())) {
+            result.setStatus(PreflightResult.Status.PAGE_OUT_OF_RANGE);
+            result.setMessage("Signature page " + signaturePage + " does not exist" +
+                (result.getPageCount() != null ? " (document has " + result.getPageCount() + " pages)" : ""));
+        }
+        return result;
+    }
+
+    private Integer findPageCount(IRandomAccessSource source, Xref xref, String head, String catalog) throws IOException {
+        // The page tree is authoritative: the linearization dictionary is not
+        // updated when an incremental update adds pages
+        Integer count = pageTreeCount(source, xref, catalog);
+        if (count != null) {
+            return count;
+        }
+
+        // Otherwise linearized files carry the page count in the first object
+        int linearized = head.indexOf("/Linearized");
+        if (linearized >= 0) {
+            int end = head.indexOf(">>", linearized);
+            Matcher pages = LINEARIZED_PAGES.matcher(head.substring(linearized, end >= 0 ? end : head.length()));
+            if (pages.find()) {
+                return Integer.valueOf(pages.group(1));
+            }
+        }
+        return null;
+    }
+
+    private Integer pageTreeCount(IRandomAccessSource source, Xref xref, String catalog) throws IOException {
+        if (catalog == null) {
+            return null;
+        }
+        Matcher pagesRef = PAGES.matcher(catalog);
+        if (!pagesRef.find()) {
+            return null;
+        }
+        String pages = resolveObject(source, xref, Integer.parseInt(pagesRef.group(1)));
+        if (pages == null) {
+            return null;
+        }
+        Matcher count = COUNT.matcher(pages);
+        return count.find() ? Integer.valueOf(count.group(1)) : null;
+    }
+
+    private boolean hasSignatureFlag(IRandomAccessSource source, Xref xref, String catalog) throws IOException {
+        if (catalog == null) {
+            return false;
+        }
+        String acroForm;
+        Matcher acroFormRef = ACROFORM_REF.matcher(catalog);
+        if (acroFormRef.find()) {
+            acroForm = resolveObject(source, xref, Integer.parseInt(acroFormRef.group(1)));
+        } else {
+            int inline = catalog.indexOf("/AcroForm");
+            acroForm = inline >= 0 ? catalog.substring(inline) : null;
+        }
+        if (acroForm == null) {
+            return false;
+        }
+        Matcher sigFlags = SIG_FLAGS.matcher(acroForm);
+        return sigFlags.find() && (Integer.parseInt(sigFlags.group(1)) & 1) != 0;
+    }
+
+    /**
+     * Cross-reference entry point: the newest section, classic table or xref
+     * stream, and its trailer. Decoded streams are cached by position so the
+     * catalog, page tree and AcroForm lookups inflate each stream once.
+     */
+    private static class Xref {
+        final long position;
+        final long base;
+        final Map<Long, PdfStream> streams = new HashMap<>();
+        String trailer;
+
+        Xref(long position, long base) {
+            this.position = position;
+            this.base = base;
+        }
+    }
+
+    /**
+     * One cross-reference section: its trailer (or xref stream dictionary) and
+     * where the requested object lives, if this section lists it.
+     */
+    private static class Section {
+        String trailer;
+        long objectOffset = -1;
+        int objectStream = -1;
+        int streamIndex;
+
+        boolean found() {
+            return objectOffset >= 0 || objectStream >= 0;
+        }
+    }
+
+    private static class PdfStream {
+        final String dictionary;
+        // Decoded content, or null when the filters are not supported or it is too large
+        final byte[] data;
+
+        PdfStream(String dictionary, byte[] data) {
+            this.dictionary = dictionary;
+            this.data = data;
+        }
+    }
+
+    private Xref openXref(IRandomAccessSource source, long position, long base) throws IOException {
+        Xref xref = new Xref(position, base);
+        Section section = readSection(source, xref, position, -1);
+        if (section == null) {
+            return null;
+        }
+        xref.trailer = section.trailer;
+        return xref;
+    }
+
+    private Section readSection(IRandomAccessSource source, Xref xref, long position, int objectNumber) throws IOException {
+        String start = read(source, position, LINE_WINDOW).stripLeading();
+        if (start.startsWith("xref")) {
+            return readClassicSection(source, position, objectNumber);
+        }
+        if (OBJECT_HEADER.matcher(start).lookingAt()) {
+            return readStreamSection(source, xref, position, objectNumber);
+        }
+        return null;
+    }
+
+    private Section readClassicSection(IRandomAccessSource source, long position, int objectNumber) throws IOException {
+        long pos = position + read(source, position, LINE_WINDOW).indexOf("xref") + "xref".length();
+        Section section = new Section();
+
+        for (int i = 0; i < MAX_SUBSECTIONS; i++) {
+            String line = read(source, pos, LINE_WINDOW);
+            int skip = 0;
+            while (skip < line.length() && Character.isWhitespace(line.charAt(skip))) {
+                skip++;
+            }
+            pos += skip;
+            line = line.substring(skip);
+
+            if (line.startsWith("trailer")) {
+                String trailer = read(source, pos, OBJECT_WINDOW);
+                int end = trailer.indexOf("startxref");
+                section.trailer = end >= 0 ? trailer.substring(0, end) : trailer;
+                return section;
+            }
+
+            Matcher subsection = SUBSECTION.matcher(line);
+            if (!subsection.lookingAt()) {
+                return null;
+            }
+            long first = Long.parseLong(subsection.group(1));
+            long count = Long.parseLong(subsection.group(2));
+            pos += subsection.end();
+
+            if (objectNumber >= first && objectNumber < first + count) {
+                String entry = read(source, pos + (objectNumber - first) * XREF_ENTRY_LENGTH, XREF_ENTRY_LENGTH);
+                if (entry.length() >= 18 && entry.charAt(17) == 'n') {
+                    section.objectOffset = Long.parseLong(entry.substring(0, 10).trim());
+                }
+            }
+            pos += count * XREF_ENTRY_LENGTH;
+        }
+        return null;
+    }
+
+    /**
+     * Reads an xref stream (PDF 1.5+). Null when the object at {@code position}
+     * is not an xref stream or its /W or /Index entries are malformed; when its
+     * filters are not supported only the dictionary is returned, so /Encrypt is
+     * still seen but objects are not located.
+     */
+    private Section readStreamSection(IRandomAccessSource source, Xref xref, long position, int objectNumber) throws IOException {
+        PdfStream stream = xref.streams.get(position);
+        if (stream == null) {
+            stream = readStream(source, position);
+            if (stream == null) {
+                return null;
+            }
+            xref.streams.put(position, stream);
+        }
+        if (!XREF_TYPE.matcher(stream.dictionary).find()) {
+            return null;
+        }
+
+        Matcher w = WIDTHS.matcher(stream.dictionary);
+        if (!w.find()) {
+            return null;
+        }
+        int[] widths = {Integer.parseInt(w.group(1)), Integer.parseInt(w.group(2)), Integer.parseInt(w.group(3))};
+        int rowLength = widths[0] + widths[1] + widths[2];
+        if (rowLength == 0 || widths[0] > 8 || widths[1] > 8 || widths[2] > 8) {
+            return null;
+        }
+
+        long[] subsections;
+        Matcher index = INDEX.matcher(stream.dictionary);
+        Matcher size = SIZE.matcher(stream.dictionary);
+        if (index.find()) {
+            String[] numbers = index.group(1).trim().split("\\s+");
+            if (numbers.length % 2 != 0 || numbers.length > 2 * MAX_SUBSECTIONS) {
+                return null;
+            }
+            subsections = new long[numbers.length];
+            for (int i = 0; i < numbers.length; i++) {
+                subsections[i] = Long.parseLong(numbers[i]);
+            }
+        } else if (size.find()) {
+            subsections = new long[] {0, Long.parseLong(size.group(1))};
+        } else {
+            return null;
+        }
+
+        Section section = new Section();
+        section.trailer = stream.dictionary;
+        if (objectNumber < 0 || stream.data == null) {
+            return section;
+        }
+        long row = 0;
+        for (int i = 0; i < subsections.length; i += 2) {
+            long first = subsections[i];
+            long count = subsections[i + 1];
+            if (objectNumber >= first && objectNumber < first + count) {
+                long start = (row + objectNumber - first) * rowLength;
+                if (start + rowLength > stream.data.length) {
+                    return section;
+                }
+                int pos = (int) start;
+                long type = widths[0] == 0 ? 1 : field(stream.data, pos, widths[0]);
+                long second = field(stream.data, pos + widths[0], widths[1]);
+                long third = field(stream.data, pos + widths[0] + widths[1], widths[2]);
+                if (type == 1) {
+                    section.objectOffset = second;
+                } else if (type == 2) {
+                    section.objectStream = (int) second;
+                    section.streamIndex = (int) third;
+                }
+                return section;
+            }
+            row += count;
+        }
+        return section;
+    }
+
+    /**
+     * Returns the text of object {@code objectNumber} up to its endobj, walking
+     * incremental updates from newest to oldest, or null when it cannot be
+     * located cheaply.
+     */
+    private String resolveObject(IRandomAccessSource source, Xref xref, int objectNumber) throws IOException {
+        Section location = locate(source, xref, objectNumber);
+        if (location == null) {
+            return null;
+        }
+        if (location.objectOffset >= 0) {
+            return readObject(source, xref.base + location.objectOffset, objectNumber);
+        }
+        return readCompressedObject(source, xref, location.objectStream, location.streamIndex, objectNumber);
+    }
+
+    private Section locate(IRandomAccessSource source, Xref xref, int objectNumber) throws IOException {
+        if (xref == null) {
+            return null;
+        }
+        long position = xref.position;
+        for (int i = 0; i < MAX_XREF_SECTIONS; i++) {
+            Section section = readSection(source, xref, position, objectNumber);
+            if (section == null) {
+                return null;
+            }
+            if (section.found()) {
+                return section;
+            }
+            // Hybrid files list their compressed objects in a side xref stream
+            Matcher xrefStm = XREF_STM.matcher(section.trailer);
+            if (xrefStm.find()) {
+                Section hybrid = readSection(source, xref, xref.base + Long.parseLong(xrefStm.group(1)), objectNumber);
+                if (hybrid != null && hybrid.found()) {
+                    return hybrid;
+                }
+            }
+            Matcher prev = PREV.matcher(section.trailer);
+            if (!prev.find()) {
+                return null;
+            }
+            position = xref.base + Long.parseLong(prev.group(1));
+        }
+        return null;
+    }
+
+    private String readObject(IRandomAccessSource source, long position, int objectNumber) throws IOException {
+        String object = read(source, position, OBJECT_WINDOW);
+        Matcher objectHeader = OBJECT_HEADER.matcher(object);
+        if (!objectHeader.lookingAt() || Integer.parseInt(objectHeader.group(1)) != objectNumber) {
+            return null;
+        }
+        int end = object.indexOf("endobj");
+        return end >= 0 ? object.substring(0, end) : object;
+    }
+
+    /** Extracts object {@code objectNumber} stored at {@code index} of an object stream. */
+    private String readCompressedObject(IRandomAccessSource source, Xref xref, int streamNumber, int index,
+                                        int objectNumber) throws IOException {
+        Section location = locate(source, xref, streamNumber);
+        if (location == null || location.objectOffset < 0) {
+            return null;
+        }
+        long position = xref.base + location.objectOffset;
+        Matcher header = OBJECT_HEADER.matcher(read(source, position, LINE_WINDOW));
+        if (!header.lookingAt() || Integer.parseInt(header.group(1)) != streamNumber) {
+            return null;
+        }
+        PdfStream stream = xref.streams.get(position);
+        if (stream == null) {
+            stream = readStream(source, position);
+            if (stream == null) {
+                return null;
+            }
+            xref.streams.put(position, stream);
+        }
+        Matcher count = OBJECT_COUNT.matcher(stream.dictionary);
+        Matcher first = FIRST.matcher(stream.dictionary);
+        if (stream.data == null || !count.find() || !first.find()) {
+            return null;
+        }
+        int objects = Integer.parseInt(count.group(1));
+        int firstOffset = Integer.parseInt(first.group(1));
+        if (index >= objects || firstOffset > stream.data.length) {
+            return null;
+        }
+
+        String content = new String(stream.data, StandardCharsets.ISO_8859_1);
+        Matcher numbers = INTEGER.matcher(content.substring(0, firstOffset));
+        long[] pairs = new long[Math.min(objects, index + 2) * 2];
+        for (int i = 0; i < pairs.length; i++) {
+            if (!numbers.find()) {
+                return null;
+            }
+            pairs[i] = Long.parseLong(numbers.group());
+        }
+        if (pairs[2 * index] != objectNumber) {
+            return null;
+        }
+        long start = firstOffset + pairs[2 * index + 1];
+        long end = index + 1 < objects ? firstOffset + pairs[2 * index + 3] : content.length();
+        if (start > end || end > content.length()) {
+            return null;
+        }
+        return content.substring((int) start, (int) end);
+    }
+
+    /**
+     * Reads the dictionary and decoded content of the stream object at
+     * {@code position}. Only unfiltered and FlateDecode streams (optionally
+     * with a PNG predictor) are decoded, and only up to MAX_STREAM_BYTES
+     * compressed / MAX_INFLATED_BYTES decoded.
+     */
+    private PdfStream readStream(IRandomAccessSource source, long position) throws IOException {
+        String object = read(source, position, OBJECT_WINDOW);
+        int keyword = object.indexOf("stream");
+        if (keyword < 0) {
+            return null;
+        }
+        String dictionary = object.substring(0, keyword);
+        int dataStart = keyword + "stream".length();
+        if (object.startsWith("\r\n", dataStart)) {
+            dataStart += 2;
+        } else if (object.startsWith("\n", dataStart) || object.startsWith("\r", dataStart)) {
+            dataStart += 1;
+        }
+
+        Matcher length = LENGTH.matcher(dictionary);
+        long declared = length.find() && length.group(2) == null ? Long.parseLong(length.group(1)) : -1;
+        Matcher filter = FILTER.matcher(dictionary);
+        String filters = filter.find() ? filter.group(1).replaceAll("[\\[\\]\\s]", "") : "";
+
+        boolean flate = filters.equals("/FlateDecode");
+        if (declared > MAX_STREAM_BYTES || (!flate && (!filters.isEmpty() || declared < 0))) {
+            return new PdfStream(dictionary, null);
+        }
+        // Inflater stops at the end of the deflate data, so an indirect /Length is not needed
+        byte[] raw = readBytes(source, position + dataStart, (int) (declared >= 0 ? declared : MAX_STREAM_BYTES));
+        byte[] data = flate ? inflate(raw) : raw;
+        return new PdfStream(dictionary, data != null ? unpredict(dictionary, data) : null);
+    }
+
+    private static byte[] inflate(byte[] compressed) throws IOException {
+        Inflater inflater = new Inflater();
+        try {
+            inflater.setInput(compressed);
+            ByteArrayOutputStream out = new ByteArrayOutputStream();
+            byte[] buffer = new byte[8192];
+            while (!inflater.finished()) {
+                int inflated = inflater.inflate(buffer);
+                if (inflated == 0 && (inflater.needsInput() || inflater.needsDictionary())) {
+                    break;
+                }
+                out.write(buffer, 0, inflated);
+                if (out.size() > MAX_INFLATED_BYTES) {
+                    return null;
+                }
+            }
+            return out.toByteArray();
+        } catch (DataFormatException e) {
+            throw new IOException("Corrupt FlateDecode stream: " + e.getMessage(), e);
+        } finally {
+            inflater.end();
+        }
+    }
+
+    /** Reverses PNG predictors (one byte per pixel, as used by xref streams). */
+    private static byte[] unpredict(String dictionary, byte[] data) {
+        Matcher predictor = PREDICTOR.matcher(dictionary);
+        int algorithm = predictor.find() ? Integer.parseInt(predictor.group(1)) : 1;
+        if (algorithm == 1) {
+            return data;
+        }
+        Matcher columns = COLUMNS.matcher(dictionary);
+        int width = columns.find() ? Integer.parseInt(columns.group(1)) : 1;
+        if (algorithm < 10 || width <= 0) {
+            return null;
+        }
+
+        int rows = data.length / (width + 1);
+        byte[] out = new byte[rows * width];
+        for (int row = 0; row < rows; row++) {
+            int in = row * (width + 1);
+            int type = data[in] & 0xff;
+            int offset = row * width;
+            for (int i = 0; i < width; i++) {
+                int raw = data[in + 1 + i] & 0xff;
+                int left = i > 0 ? out[offset + i - 1] & 0xff : 0;
+                int up = row > 0 ? out[offset - width + i] & 0xff : 0;
+                int upLeft = row > 0 && i > 0 ? out[offset - width + i - 1] & 0xff : 0;
+                int value = switch (type) {
+                    case 0 -> raw;
+                    case 1 -> raw + left;
+                    case 2 -> raw + up;
+                    case 3 -> raw + (left + up) / 2;
+                    case 4 -> raw + paeth(left, up, upLeft);
+                    default -> -1;
+                };
+                if (value < 0) {
+                    return null;
+                }
+                out[offset + i] = (byte) value;
+            }
+        }
+        return out;
+    }
+
+    private static int paeth(int left, int up, int upLeft) {
+        int estimate = left + up - upLeft;
+        int toLeft = Math.abs(estimate - left);
+        int toUp = Math.abs(estimate - up);
+        int toUpLeft = Math.abs(estimate - upLeft);
+        if (toLeft <= toUp && toLeft <= toUpLeft) {
+            return left;
+        }
+        return toUp <= toUpLeft ? up : upLeft;
+    }
+
+    private static long field(byte[] data, int offset, int width) {
+        long value = 0;
+        for (int i = 0; i < width; i++) {
+            value = (value << 8) | (data[offset + i] & 0xff);
+        }
+        return value;
+    }
+
+    /**
+     * Offset of the last occurrence of {@code marker} before {@code end},
+     * scanning backwards one window at a time, or -1 if there is none.
+     */
+    private long findLast(IRandomAccessSource source, String marker, long end) throws IOException {
+        long windowEnd = end;
+        while (windowEnd > 0) {
+            long windowStart = Math.max(0, windowEnd - TAIL_WINDOW);
+            int index = read(source, windowStart, (int) (windowEnd - windowStart)).lastIndexOf(marker);
+            if (index >= 0) {
+                return windowStart + index;
+            }
+            if (windowStart == 0) {
+                break;
+            }
+            // Overlap so a marker split across two windows is still found
+            windowEnd = windowStart + marker.length() - 1;
+        }
+        return -1;
+    }
+
+    private String read(IRandomAccessSource source, long offset, int length) throws IOException {
+        return new String(readBytes(source, offset, length), StandardCharsets.ISO_8859_1);
+    }
+
+    private byte[] readBytes(IRandomAccessSource source, long offset, int length) throws IOException {
+        long available = Math.max(0, source.length() - offset);
+        int size = (int) Math.min(length, available);
+        byte[] buffer = new byte[size];
+        int filled = 0;
+        while (filled < size) {
+            int read = source.get(offset + filled, buffer, filled, size - filled);
+            if (read <= 0) {
+                break;
+            }
+            filled += read;
+        }
+        return filled == size ? buffer : Arrays.copyOf(buffer, filled);
+    }
+}
@@ -0,0 +1,336 @@
+package com.firmador.backend.service;
+
+import com.amazon.corretto.crypto.provider.AmazonCorrettoCryptoProvider;
+import com.itextpdf.signatures.DigestAlgorithms;
+import com.itextpdf.signatures.IExternalDigest;
+import com.itextpdf.signatures.IExternalSignature;
+import com.itextpdf.signatures.PrivateKeySignature;
+import com.itextpdf.signatures.ProviderDigest;
+import jakarta.annotation.PostConstruct;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.stereotype.Service;
+
+import java.security.*;
+import java.security.interfaces.RSAKey;
+import java.security.spec.ECGenParameterSpec;
+import java.util.*;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Chooses the JCA provider used for the signature and digest operations of
+ * {@link DigitalSignatureService}.
+ *
+ * Amazon Corretto Crypto Provider, which runs RSA, ECDSA and SHA-256 in
+ * OpenSSL-derived native code (AWS-LC), heads the candidates whenever its
+ * native library loads on this platform; the JDK providers and BouncyCastle
+ * follow. By default the first candidate supporting each operation is used,
+ * which costs nothing at startup.
+ *
+ * With {@code firmador.signature.benchmark-enabled} every candidate is
+ * instead timed signing with throwaway RSA keys of each configured size and
+ * an EC key, and hashing a 1 MB buffer, on as many threads as the signing
+ * workers after a timed warm-up; the highest throughput per operation wins
+ * and RSA keys use the result for the nearest measured size. That takes
+ * several seconds of full load, so it is meant for choosing the order once
+ * per machine type, not for every boot.
+ *
+ * A further provider can be named in
+ * {@code firmador.signature.extra-provider-class}. BouncyCastle is always the
+ * fallback when the chosen provider fails on a given key.
+ */
+@Service
+public class SignatureProviderSelector {
+
+    private static final Logger logger = LoggerFactory.getLogger(SignatureProviderSelector.class);
+
+    private static final String FALLBACK_PROVIDER = "BC";
+    private static final String DIGEST_KEY = "SHA-256";
+
+    private final List<String> candidates;
+    private final boolean nativeProviderEnabled;
+    private final String extraProviderClass;
+    private final boolean benchmarkEnabled;
+    private final List<Integer> rsaKeySizes;
+    private final int threads;
+    private final long warmupNanos;
+    private final long measureNanos;
+    private final Map<String, String> selected = new HashMap<>();
+
+    public SignatureProviderSelector(@Value("${firmador.signature.providers:SunRsaSign,SunEC,SUN,BC}") List<String> candidates,
+                                     @Value("${firmador.signature.native-provider-enabled:true}") boolean nativeProviderEnabled,
+                                     @Value("${firmador.signature.extra-provider-class:}") String extraProviderClass,
+                                     @Value("${firmador.signature.benchmark-enabled:false}") boolean benchmarkEnabled,
+                                     @Value("${firmador.signature.benchmark-rsa-bits:2048,3072,4096}") List<Integer> rsaKeySizes,
+                                     @Value("${firmador.signature.benchmark-threads:${firmador.cluster.workers:0}}") int threads,
+                                     @Value("${firmador.signature.benchmark-warmup-millis:500}") long warmupMillis,
+                                     @Value("${firmador.signature.benchmark-measure-millis:500}") long measureMillis) {
+        this.candidates = new ArrayList<>(candidates);
+        this.nativeProviderEnabled = nativeProviderEnabled;
+        this.extraProviderClass = extraProviderClass;
+        this.benchmarkEnabled = benchmarkEnabled;
+        this.rsaKeySizes = new ArrayList<>(rsaKeySizes);
+        Collections.sort(this.rsaKeySizes);
+        this.threads = threads > 0 ? threads : Runtime.getRuntime().availableProcessors();
+        this.warmupNanos = TimeUnit.MILLISECONDS.toNanos(warmupMillis);
+        this.measureNanos = TimeUnit.MILLISECONDS.toNanos(measureMillis);
+    }
+
+    /** One benchmarked call; each thread gets its own instance. */
+    @FunctionalInterface
+    private interface Operation {
+        void run() throws GeneralSecurityException;
+    }
+
+    @FunctionalInterface
+    private interface OperationFactory {
+        Operation create() throws GeneralSecurityException;
+    }
+
+    @FunctionalInterface
+    private interface ProviderOperation {
+        Operation create(String provider) throws GeneralSecurityException;
+    }
+
+    @PostConstruct
+    public void select() {
+        if (Security.getProvider(FALLBACK_PROVIDER) == null) {
+            Security.addProvider(new org.bouncycastle.jce.provider.BouncyCastleProvider());
+        }
+        registerExtraProvider();
+        registerNativeProvider();
+
+        if (!benchmarkEnabled) {
+            for (int bits : rsaKeySizes) {
+                selected.put("RSA-" + bits, firstSupporting("Signature", "SHA256withRSA"));
+            }
+            selected.put("EC", firstSupporting("Signature", "SHA256withECDSA"));
+            selected.put(DIGEST_KEY, firstSupporting("MessageDigest", DIGEST_KEY));
+            logger.info("Selected signature providers by preference: {}", selected);
+            return;
+        }
+
+        logger.info("Benchmarking signature providers on {} threads", threads);
+        try {
+            KeyPairGenerator rsaGenerator = KeyPairGenerator.getInstance("RSA");
+            for (int bits : rsaKeySizes) {
+                rsaGenerator.initialize(bits);
+                selected.put("RSA-" + bits, fastestSigner("SHA256withRSA", rsaGenerator.generateKeyPair().getPrivate()));
+            }
+
+            KeyPairGenerator ecGenerator = KeyPairGenerator.getInstance("EC");
+            ecGenerator.initialize(new ECGenParameterSpec("secp256r1"));
+            selected.put("EC", fastestSigner("SHA256withECDSA", ecGenerator.generateKeyPair().getPrivate()));
+
+            selected.put(DIGEST_KEY, fastestDigest());
+        } catch (GeneralSecurityException e) {
+            logger.warn("Signature provider benchmark failed, using {}: {}", FALLBACK_PROVIDER, e.getMessage());
+            selected.clear();
+        }
+        logger.info("Selected signature providers: {}", selected);
+    }
+
+    private void registerExtraProvider() {
+        if (extraProviderClass == null || extraProviderClass.isBlank()) {
+            return;
+        }
+        try {
+            Provider provider = (Provider) Class.forName(extraProviderClass).getDeclaredConstructor().newInstance();
+            if (Security.getProvider(provider.getName()) == null) {
+                Security.addProvider(provider);
+            }
+            candidates.add(0, provider.getName());
+            logger.info("Registered extra security provider {}", provider.getName());
+        } catch (ReflectiveOperationException | LinkageError e) {
+            logger.warn("Could not load security provider {}: {}", extraProviderClass, e.getMessage());
+        }
+    }
+
+    /**
+     * Puts ACCP first. Its JAR is always on the classpath, but the native
+     * library only loads on the Linux architecture it was built for; anywhere
+     * else the JDK providers are used as before.
+     */
+    private void registerNativeProvider() {
+        if (!nativeProviderEnabled) {
+            return;
+        }
+        try {
+            AmazonCorrettoCryptoProvider provider = AmazonCorrettoCryptoProvider.INSTANCE;
+            Throwable loadingError = provider.getLoadingError();
+            if (loadingError != null) {
+                logger.info("OpenSSL-backed provider unavailable on this platform: {}", loadingError.getMessage());
+                return;
+            }
+            if (Security.getProvider(provider.getName()) == null) {
+                Security.addProvider(provider);
+            }
+            candidates.remove(provider.getName());
+            candidates.add(0, provider.getName());
+            logger.info("Registered OpenSSL-backed provider {} {}", provider.getName(), provider.getVersionStr());
+        } catch (LinkageError e) {
+            logger.info("OpenSSL-backed provider unavailable on this platform: {}", e.getMessage());
+        }
+    }
+
+    private String firstSupporting(String type, String algorithm) {
+        for (String name : candidates) {
+            Provider provider = Security.getProvider(name);
+            if (provider != null && provider.getService(type, algorithm) != null) {
+                return name;
+            }
+        }
+        return FALLBACK_PROVIDER;
+    }
+
+    private String fastestSigner(String algorithm, PrivateKey key) {
+        byte[] message = new byte[64];
+        String label = key instanceof RSAKey ?
+            algorithm + " (" + ((RSAKey) key).getModulus().bitLength() + " bits)" : algorithm;
+        return fastest(label, "signatures", provider -> {
+            Signature signature = Signature.getInstance(algorithm, provider);
+            return () -> {
+                signature.initSign(key);
+                signature.update(message);
+                signature.sign();
+            };
+        });
+    }
+
+    private String fastestDigest() {
+        byte[] buffer = new byte[1 << 20];
+        return fastest(DIGEST_KEY, "MB", provider -> {
+            MessageDigest digest = MessageDigest.getInstance(DIGEST_KEY, provider);
+            return () -> digest.digest(buffer);
+        });
+    }
+
+    private String fastest(String label, String unit, ProviderOperation operation) {
+        String fastest = FALLBACK_PROVIDER;
+        double best = 0;
+        for (String provider : candidates) {
+            try {
+                double perSecond = throughput(() -> operation.create(provider));
+                logger.info("{} with {}: {} {}/s on {} threads", label, provider, Math.round(perSecond), unit, threads);
+                if (perSecond > best) {
+                    best = perSecond;
+                    fastest = provider;
+                }
+            } catch (GeneralSecurityException e) {
+                logger.debug("{} does not support {}: {}", provider, label, e.getMessage());
+            }
+        }
+        return fastest;
+    }
+
+    /**
+     * Operations per second with every thread running its own instance: all
+     * threads warm up until a shared deadline so the JIT has compiled the hot
+     * path, then count completed operations until the second deadline.
+     */
+    private double throughput(OperationFactory factory) throws GeneralSecurityException {
+        List<Operation> operations = new ArrayList<>();
+        for (int i = 0; i < threads; i++) {
+            operations.add(factory.create());
+        }
+
+        ExecutorService pool = Executors.newFixedThreadPool(threads);
+        try {
+            long measureStart = System.nanoTime() + warmupNanos;
+            long measureEnd = measureStart + measureNanos;
+            List<Future<Long>> counts = new ArrayList<>();
+            for (Operation operation : operations) {
+                counts.add(pool.submit(() -> {
+                    while (System.nanoTime() < measureStart) {
+                        operation.run();
+                    }
+                    long completed = 0;
+                    while (System.nanoTime() < measureEnd) {
+                        operation.run();
+                        completed++;
+                    }
+                    return completed;
+                }));
+            }
+            long total = 0;
+            for (Future<Long> count : counts) {
+                total += count.get();
+            }
+            return total * 1e9 / measureNanos;
+        } catch (ExecutionException e) {
+            if (e.getCause() instanceof GeneralSecurityException) {
+                throw (GeneralSecurityException) e.getCause();
+            }
+            throw new GeneralSecurityException(e.getCause());
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new GeneralSecurityException(e);
+        } finally {
+            pool.shutdownNow();
+        }
+    }
+
+    public String providerFor(PrivateKey key) {
+        return selected.getOrDefault(selectionKey(key), FALLBACK_PROVIDER);
+    }
+
+    /** RSA results are kept per key size; other keys by algorithm. */
+    private String selectionKey(PrivateKey key) {
+        if (!"RSA".equals(key.getAlgorithm()) || rsaKeySizes.isEmpty()) {
+            return key.getAlgorithm();
+        }
+        int measured = rsaKeySizes.get(rsaKeySizes.size() - 1);
+        if (key instanceof RSAKey) {
+            int bits = ((RSAKey) key).getModulus().bitLength();
+            for (int size : rsaKeySizes) {
+                if (Math.abs(size - bits) < Math.abs(measured - bits)) {
+                    measured = size;
+                }
+            }
+        }
+        return "RSA-" + measured;
+    }
+
+    public IExternalDigest createDigest() {
+        return new ProviderDigest(selected.getOrDefault(DIGEST_KEY, FALLBACK_PROVIDER));
+    }
+
+    /**
+     * Signature backed by the selected provider for the key's algorithm that
+     * retries with BouncyCastle if the provider rejects the key.
+     */
+    public IExternalSignature createSignature(PrivateKey key) {
+        String provider = providerFor(key);
+        IExternalSignature fallback = new PrivateKeySignature(key, DigestAlgorithms.SHA256, FALLBACK_PROVIDER);
+        if (FALLBACK_PROVIDER.equals(provider)) {
+            return fallback;
+        }
+        IExternalSignature primary = new PrivateKeySignature(key, DigestAlgorithms.SHA256, provider);
+        return new IExternalSignature() {
+            @Override
+            public String getHashAlgorithm() {
+                return primary.getHashAlgorithm();
+            }
+
+            @Override
+            public String getEncryptionAlgorithm() {
+                return primary.getEncryptionAlgorithm();
+            }
+
+            @Override
+            public byte[] sign(byte[] message) throws GeneralSecurityException {
+                try {
+                    return primary.sign(message);
+                } catch (GeneralSecurityException e) {
+                    logger.warn("Signing with {} failed, falling back to {}: {}", provider, FALLBACK_PROVIDER, e.getMessage());
+                    return fallback.sign(message);
+                }
+            }
+        };
+    }
+}
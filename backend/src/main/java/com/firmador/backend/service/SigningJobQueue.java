@@ -0,0 +1,571 @@
+package com.firmador.backend.service;
+
+import com.fasterxml.jackson.databind.ObjectMapper;
+import com.firmador.backend.dto.SignatureRequest;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.stereotype.Service;
+
+import javax.crypto.Cipher;
+import javax.crypto.SecretKey;
+import javax.crypto.spec.GCMParameterSpec;
+import javax.crypto.spec.SecretKeySpec;
+import java.io.IOException;
+import java.io.UncheckedIOException;
+import java.net.InetAddress;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.*;
+import java.nio.file.attribute.FileTime;
+import java.nio.file.attribute.PosixFilePermissions;
+import java.security.GeneralSecurityException;
+import java.security.MessageDigest;
+import java.security.SecureRandom;
+import java.time.Duration;
+import java.time.Instant;
+import java.util.*;
+import java.util.concurrent.ThreadLocalRandom;
+import java.util.stream.Collectors;
+import java.util.stream.Stream;
+
+/**
+ * Durable signing queue shared by every backend instance through a common
+ * directory (a shared volume or NFS mount).
+ *
+ * Jobs move between state directories with atomic renames, so exactly one
+ * instance wins each claim without any coordinator:
+ * <pre>
+ *   incoming/&lt;id&gt;  -&gt;  pending/&lt;id&gt;  -&gt;  claimed/&lt;id&gt;  -&gt;  done/&lt;id&gt; | failed/&lt;id&gt;
+ * </pre>
+ * A claimed job holds a lease file whose mtime is refreshed by its worker's
+ * heartbeat. Jobs whose lease expires (the instance died) are moved back to
+ * pending and picked up by another instance.
+ *
+ * The request, which carries the PKCS#12 and its password, is stored
+ * encrypted with AES-GCM under {@code firmador.cluster.secret-key}, shared by
+ * every instance, so the key material never reaches the share in clear.
+ */
+@Service
+public class SigningJobQueue {
+
+    private static final Logger logger = LoggerFactory.getLogger(SigningJobQueue.class);
+
+    private static final String INCOMING = "incoming";
+    private static final String PENDING = "pending";
+    private static final String CLAIMED = "claimed";
+    private static final String DONE = "done";
+    private static final String FAILED = "failed";
+
+    private static final String REQUEST_FILE = "request.enc";
+    private static final String DOCUMENT_FILE = "document.pdf";
+    private static final String FILENAME_FILE = "filename";
+    private static final String LEASE_FILE = "lease";
+    private static final String RESULT_FILE = "result.pdf";
+    private static final String STATUS_FILE = "status.json";
+    private static final String FINISHING = ".finishing.";
+
+    // Number of oldest pending jobs a claim picks its first candidate from
+    private static final int CLAIM_SPREAD = 8;
+
+    private static final String CIPHER = "AES/GCM/NoPadding";
+    private static final int KEY_ID_LENGTH = 8;
+    private static final int IV_LENGTH = 12;
+    private static final int TAG_BITS = 128;
+
+    public enum JobState {
+        PENDING,
+        RUNNING,
+        DONE,
+        FAILED
+    }
+
+    public static class ClaimedJob {
+        private final String jobId;
+        private final String filename;
+        private final byte[] document;
+        private final SignatureRequest request;
+
+        public ClaimedJob(String jobId, String filename, byte[] document, SignatureRequest request) {
+            this.jobId = jobId;
+            this.filename = filename;
+            this.document = document;
+            this.request = request;
+        }
+
+        public String getJobId() { return jobId; }
+        public String getFilename() { return filename; }
+        public byte[] getDocument() { return document; }
+        public SignatureRequest getRequest() { return request; }
+    }
+
+    public static class JobStatus {
+        private String jobId;
+        private JobState state;
+        private String instanceId;
+        private String filename;
+        private String message;
+        private Instant updatedAt;
+
+        public JobStatus() {}
+
+        public JobStatus(String jobId, JobState state, String instanceId, String filename,
+                         String message, Instant updatedAt) {
+            this.jobId = jobId;
+            this.state = state;
+            this.instanceId = instanceId;
+            this.filename = filename;
+            this.message = message;
+            this.updatedAt = updatedAt;
+        }
+
+        public String getJobId() { return jobId; }
+        public void setJobId(String jobId) { this.jobId = jobId; }
+        public JobState getState() { return state; }
+        public void setState(JobState state) { this.state = state; }
+        public String getInstanceId() { return instanceId; }
+        public void setInstanceId(String instanceId) { this.instanceId = instanceId; }
+        public String getFilename() { return filename; }
+        public void setFilename(String filename) { this.filename = filename; }
+        public String getMessage() { return message; }
+        public void setMessage(String message) { this.message = message; }
+        public Instant getUpdatedAt() { return updatedAt; }
+        public void setUpdatedAt(Instant updatedAt) { this.updatedAt = updatedAt; }
+    }
+
+    private final ObjectMapper objectMapper;
+    private final boolean enabled;
+    private final Path root;
+    private final Duration leaseDuration;
+    private final Duration resultRetention;
+    private final String instanceId;
+    private final SecretKey secretKey;
+    private final byte[] keyId;
+    private final SecureRandom random = new SecureRandom();
+
+    public SigningJobQueue(ObjectMapper objectMapper,
+                           @Value("${firmador.cluster.enabled:false}") boolean enabled,
+                           @Value("${firmador.cluster.queue-path:${java.io.tmpdir}/firmador-queue}") String queuePath,
+                           @Value("${firmador.cluster.lease-seconds:60}") long leaseSeconds,
+                           @Value("${firmador.cluster.result-retention-minutes:60}") long resultRetentionMinutes,
+                           @Value("${firmador.cluster.instance-id:}") String instanceId,
+                           @Value("${firmador.cluster.secret-key:}") String secretKey) throws IOException {
+        this.objectMapper = objectMapper;
+        this.enabled = enabled;
+        this.root = Paths.get(queuePath);
+        this.leaseDuration = Duration.ofSeconds(leaseSeconds);
+        this.resultRetention = Duration.ofMinutes(resultRetentionMinutes);
+        this.instanceId = instanceId == null || instanceId.isBlank() ? defaultInstanceId() : instanceId;
+        this.secretKey = enabled ? parseSecretKey(secretKey) : null;
+        this.keyId = enabled ? keyId(this.secretKey) : null;
+
+        if (enabled) {
+            for (String state : List.of(INCOMING, PENDING, CLAIMED, DONE, FAILED)) {
+                Files.createDirectories(root.resolve(state));
+            }
+            logger.info("Cluster signing queue at {} (instance {})", root, this.instanceId);
+        }
+    }
+
+    public boolean isEnabled() {
+        return enabled;
+    }
+
+    public String getInstanceId() {
+        return instanceId;
+    }
+
+    /**
+     * Persists a job and publishes it to the pending directory. The job only
+     * becomes visible to workers once all its files are written.
+     */
+    public String submit(byte[] document, String filename, SignatureRequest request) throws IOException {
+        String jobId = UUID.randomUUID().toString();
+        Path staging = root.resolve(INCOMING).resolve(jobId);
+        Files.createDirectory(staging);
+        // The request carries the PKCS#12 and its password
+        byte[] plaintext = objectMapper.writeValueAsBytes(request);
+        try {
+            writePrivate(staging.resolve(REQUEST_FILE), seal(jobId, plaintext));
+        } finally {
+            Arrays.fill(plaintext, (byte) 0);
+        }
+        writePrivate(staging.resolve(DOCUMENT_FILE), document);
+        writePrivate(staging.resolve(FILENAME_FILE), filename.getBytes(StandardCharsets.UTF_8));
+        Files.move(staging, root.resolve(PENDING).resolve(jobId), StandardCopyOption.ATOMIC_MOVE);
+        logger.info("Job {} submitted by instance {}", jobId, instanceId);
+        return jobId;
+    }
+
+    /**
+     * Claims one of the oldest pending jobs, or returns empty when the queue
+     * is idle or every candidate was taken by another instance first.
+     */
+    public Optional<ClaimedJob> claim() throws IOException {
+        List<Path> candidates;
+        try (Stream<Path> pending = Files.list(root.resolve(PENDING))) {
+            // One stat per entry, not one per comparison
+            candidates = pending.map(path -> Map.entry(path, lastModified(path)))
+                .sorted(Map.Entry.comparingByValue())
+                .map(Map.Entry::getKey)
+                .collect(Collectors.toCollection(ArrayList::new));
+        }
+        // Every worker on every instance lists the same directory; starting
+        // from a random one of the oldest few spreads them over different jobs
+        // instead of all racing for the head of the queue
+        Collections.shuffle(candidates.subList(0, Math.min(CLAIM_SPREAD, candidates.size())),
+            ThreadLocalRandom.current());
+
+        for (Path candidate : candidates) {
+            String jobId = candidate.getFileName().toString();
+            Path claimed = root.resolve(CLAIMED).resolve(jobId);
+            try {
+                // A fresh mtime keeps the reaper from judging the claim expired
+                // by the job's age before its lease file exists
+                Files.setLastModifiedTime(candidate, FileTime.from(Instant.now()));
+                Files.move(candidate, claimed, StandardCopyOption.ATOMIC_MOVE);
+            } catch (NoSuchFileException | FileAlreadyExistsException | DirectoryNotEmptyException e) {
+                continue; // Another instance won the race
+            }
+            Files.write(claimed.resolve(LEASE_FILE), instanceId.getBytes(StandardCharsets.UTF_8));
+
+            try {
+                SignatureRequest request;
+                byte[] plaintext = open(jobId, Files.readAllBytes(claimed.resolve(REQUEST_FILE)));
+                try {
+                    request = objectMapper.readValue(plaintext, SignatureRequest.class);
+                } finally {
+                    Arrays.fill(plaintext, (byte) 0);
+                }
+                byte[] document = Files.readAllBytes(claimed.resolve(DOCUMENT_FILE));
+                String filename = Files.readString(claimed.resolve(FILENAME_FILE));
+                logger.debug("Job {} claimed by instance {}", jobId, instanceId);
+                return Optional.of(new ClaimedJob(jobId, filename, document, request));
+            } catch (ForeignKeyException e) {
+                // Sealed by an instance with another key: leave it to that one
+                logger.error("Job {} was encrypted with a different cluster key; check firmador.cluster.secret-key", jobId);
+                release(claimed);
+            } catch (IOException e) {
+                // A job that cannot be read would otherwise bounce between instances forever
+                logger.error("Job {} is unreadable, marking as failed", jobId, e);
+                fail(jobId, "Trabajo ilegible: " + e.getMessage());
+            }
+        }
+        return Optional.empty();
+    }
+
+    /**
+     * Extends the lease of a job this instance is working on. Returns false if
+     * the lease was lost, in which case another instance may run the job.
+     */
+    public boolean heartbeat(String jobId) {
+        Path lease = root.resolve(CLAIMED).resolve(jobId).resolve(LEASE_FILE);
+        try {
+            if (!instanceId.equals(Files.readString(lease))) {
+                return false;
+            }
+            Files.setLastModifiedTime(lease, FileTime.from(Instant.now()));
+            return true;
+        } catch (IOException e) {
+            return false;
+        }
+    }
+
+    /**
+     * Publishes the signed document. Returns false, discarding the result,
+     * when this instance no longer holds the job's lease.
+     */
+    public boolean complete(String jobId, byte[] result, String filename) throws IOException {
+        return finish(jobId, DONE, result, new JobStatus(jobId, JobState.DONE, instanceId, filename,
+            "Documento firmado exitosamente", Instant.now()));
+    }
+
+    public boolean fail(String jobId, String message) throws IOException {
+        return finish(jobId, FAILED, null, new JobStatus(jobId, JobState.FAILED, instanceId, null,
+            message, Instant.now()));
+    }
+
+    /**
+     * Moves a claimed job to done/ or failed/. The job directory is first
+     * renamed out of claimed/ and its lease checked there: once it has left
+     * claimed/ the reaper cannot hand it to another instance, and a directory
+     * that was reaped and re-claimed in the meantime (its lease names another
+     * instance) is put back untouched instead of deleted.
+     */
+    private boolean finish(String jobId, String state, byte[] result, JobStatus status) throws IOException {
+        Path claimed = root.resolve(CLAIMED).resolve(jobId);
+        if (!holdsLease(claimed)) {
+            logger.warn("Lease on job {} was lost, discarding result from {}", jobId, instanceId);
+            return false;
+        }
+        Path finishing = root.resolve(INCOMING).resolve(jobId + FINISHING + UUID.randomUUID());
+        try {
+            Files.move(claimed, finishing, StandardCopyOption.ATOMIC_MOVE);
+        } catch (NoSuchFileException e) {
+            logger.warn("Job {} was reaped before instance {} finished it", jobId, instanceId);
+            return false;
+        }
+        if (!holdsLease(finishing)) {
+            logger.warn("Job {} was re-claimed by another instance, discarding result from {}", jobId, instanceId);
+            try {
+                Files.move(finishing, claimed, StandardCopyOption.ATOMIC_MOVE);
+            } catch (IOException e) {
+                logger.error("Could not return job {} to its new owner", jobId, e);
+            }
+            return false;
+        }
+
+        // The request carries the PKCS#12; nothing but the outcome is kept
+        for (String file : List.of(REQUEST_FILE, DOCUMENT_FILE, FILENAME_FILE, LEASE_FILE)) {
+            Files.deleteIfExists(finishing.resolve(file));
+        }
+        if (result != null) {
+            Files.write(finishing.resolve(RESULT_FILE), result);
+        }
+        Files.write(finishing.resolve(STATUS_FILE), objectMapper.writeValueAsBytes(status));
+        try {
+            Files.move(finishing, root.resolve(state).resolve(jobId), StandardCopyOption.ATOMIC_MOVE);
+            return true;
+        } catch (FileAlreadyExistsException | DirectoryNotEmptyException e) {
+            // The lease expired and another instance already finished the job
+            logger.warn("Job {} was already finished elsewhere, discarding result from {}", jobId, instanceId);
+            deleteRecursively(finishing);
+            return false;
+        }
+    }
+
+    private boolean holdsLease(Path job) {
+        try {
+            return instanceId.equals(Files.readString(job.resolve(LEASE_FILE)));
+        } catch (IOException e) {
+            return false;
+        }
+    }
+
+    /**
+     * Returns jobs whose lease expired to the pending directory.
+     */
+    public int reapExpiredLeases() throws IOException {
+        int reaped = 0;
+        Instant deadline = Instant.now().minus(leaseDuration);
+        try (Stream<Path> claimed = Files.list(root.resolve(CLAIMED))) {
+            for (Path job : claimed.toList()) {
+                Path lease = job.resolve(LEASE_FILE);
+                Instant touched = lastModified(Files.exists(lease) ? lease : job).toInstant();
+                if (touched.isAfter(deadline)) {
+                    continue;
+                }
+                if (release(job)) {
+                    logger.warn("Lease on job {} expired, returned to queue", job.getFileName());
+                    reaped++;
+                }
+            }
+        }
+        return reaped;
+    }
+
+    /**
+     * Moves a claimed job back to pending. The lease goes first: once the job
+     * is back in pending another instance may claim it and write its own
+     * lease, which must not be the one deleted here.
+     */
+    private boolean release(Path claimedJob) throws IOException {
+        try {
+            Files.deleteIfExists(claimedJob.resolve(LEASE_FILE));
+            Files.move(claimedJob, root.resolve(PENDING).resolve(claimedJob.getFileName()), StandardCopyOption.ATOMIC_MOVE);
+            return true;
+        } catch (NoSuchFileException | FileAlreadyExistsException | DirectoryNotEmptyException e) {
+            return false; // Finished or reaped concurrently
+        }
+    }
+
+    /**
+     * Removes finished jobs older than the retention window, and staging
+     * directories in incoming/ left behind by a submit or finish that died
+     * before its rename.
+     */
+    public void purgeExpired() throws IOException {
+        Instant deadline = Instant.now().minus(resultRetention);
+        for (String state : List.of(DONE, FAILED)) {
+            try (Stream<Path> jobs = Files.list(root.resolve(state))) {
+                for (Path job : jobs.toList()) {
+                    if (lastModified(job).toInstant().isBefore(deadline)) {
+                        deleteRecursively(job);
+                    }
+                }
+            }
+        }
+
+        // Staging only lasts as long as writing its files, far less than a lease
+        Instant stale = Instant.now().minus(leaseDuration);
+        try (Stream<Path> incoming = Files.list(root.resolve(INCOMING))) {
+            for (Path entry : incoming.toList()) {
+                if (newestModification(entry).isBefore(stale)) {
+                    logger.warn("Removing abandoned staging entry {}", entry.getFileName());
+                    deleteRecursively(entry);
+                }
+            }
+        }
+    }
+
+    public Optional<JobStatus> status(String jobId) throws IOException {
+        if (!isValidJobId(jobId)) {
+            return Optional.empty();
+        }
+        for (String state : List.of(DONE, FAILED)) {
+            Path status = root.resolve(state).resolve(jobId).resolve(STATUS_FILE);
+            if (Files.exists(status)) {
+                return Optional.of(objectMapper.readValue(status.toFile(), JobStatus.class));
+            }
+        }
+        Path claimed = root.resolve(CLAIMED).resolve(jobId);
+        if (Files.exists(claimed)) {
+            Path lease = claimed.resolve(LEASE_FILE);
+            String owner = Files.exists(lease) ? Files.readString(lease) : null;
+            return Optional.of(new JobStatus(jobId, JobState.RUNNING, owner, null,
+                "Firmando documento", lastModified(claimed).toInstant()));
+        }
+        Path pending = root.resolve(PENDING).resolve(jobId);
+        if (Files.exists(pending)) {
+            return Optional.of(new JobStatus(jobId, JobState.PENDING, null, null,
+                "En cola", lastModified(pending).toInstant()));
+        }
+        // Between leaving claimed/ and reaching done/ or failed/
+        try (DirectoryStream<Path> finishing = Files.newDirectoryStream(root.resolve(INCOMING), jobId + FINISHING + "*")) {
+            if (finishing.iterator().hasNext()) {
+                return Optional.of(new JobStatus(jobId, JobState.RUNNING, null, null,
+                    "Firmando documento", Instant.now()));
+            }
+        }
+        return Optional.empty();
+    }
+
+    public Optional<Path> resultPath(String jobId) {
+        if (!isValidJobId(jobId)) {
+            return Optional.empty();
+        }
+        Path result = root.resolve(DONE).resolve(jobId).resolve(RESULT_FILE);
+        return Files.exists(result) ? Optional.of(result) : Optional.empty();
+    }
+
+    private static boolean isValidJobId(String jobId) {
+        try {
+            return UUID.fromString(jobId).toString().equals(jobId);
+        } catch (IllegalArgumentException e) {
+            return false;
+        }
+    }
+
+    private byte[] seal(String jobId, byte[] plaintext) throws IOException {
+        try {
+            byte[] iv = new byte[IV_LENGTH];
+            random.nextBytes(iv);
+            Cipher cipher = Cipher.getInstance(CIPHER);
+            cipher.init(Cipher.ENCRYPT_MODE, secretKey, new GCMParameterSpec(TAG_BITS, iv));
+            // Bound to the job id so a sealed request cannot be replayed under another job
+            cipher.updateAAD(jobId.getBytes(StandardCharsets.UTF_8));
+            byte[] ciphertext = cipher.doFinal(plaintext);
+            return ByteBuffer.allocate(KEY_ID_LENGTH + IV_LENGTH + ciphertext.length)
+                .put(keyId).put(iv).put(ciphertext).array();
+        } catch (GeneralSecurityException e) {
+            throw new IOException("Could not encrypt job " + jobId, e);
+        }
+    }
+
+    private byte[] open(String jobId, byte[] sealed) throws IOException {
+        if (sealed.length < KEY_ID_LENGTH + IV_LENGTH ||
+                !MessageDigest.isEqual(keyId, Arrays.copyOf(sealed, KEY_ID_LENGTH))) {
+            throw new ForeignKeyException();
+        }
+        try {
+            Cipher cipher = Cipher.getInstance(CIPHER);
+            cipher.init(Cipher.DECRYPT_MODE, secretKey,
+                new GCMParameterSpec(TAG_BITS, sealed, KEY_ID_LENGTH, IV_LENGTH));
+            cipher.updateAAD(jobId.getBytes(StandardCharsets.UTF_8));
+            int offset = KEY_ID_LENGTH + IV_LENGTH;
+            return cipher.doFinal(sealed, offset, sealed.length - offset);
+        } catch (GeneralSecurityException e) {
+            throw new IOException("Could not decrypt job " + jobId, e);
+        }
+    }
+
+    private static class ForeignKeyException extends IOException {
+    }
+
+    private static SecretKey parseSecretKey(String encoded) {
+        if (encoded == null || encoded.isBlank()) {
+            throw new IllegalStateException(
+                "firmador.cluster.secret-key is required in cluster mode (base64 of 32 random bytes)");
+        }
+        byte[] key;
+        try {
+            key = Base64.getDecoder().decode(encoded.trim());
+        } catch (IllegalArgumentException e) {
+            throw new IllegalStateException("firmador.cluster.secret-key is not valid base64", e);
+        }
+        if (key.length != 32) {
+            throw new IllegalStateException("firmador.cluster.secret-key must decode to 32 bytes");
+        }
+        return new SecretKeySpec(key, "AES");
+    }
+
+    // Lets an instance tell a job sealed under another key from a corrupt one
+    private static byte[] keyId(SecretKey key) {
+        try {
+            MessageDigest digest = MessageDigest.getInstance("SHA-256");
+            digest.update("firmador-cluster-key-id".getBytes(StandardCharsets.UTF_8));
+            return Arrays.copyOf(digest.digest(key.getEncoded()), KEY_ID_LENGTH);
+        } catch (GeneralSecurityException e) {
+            throw new IllegalStateException(e);
+        }
+    }
+
+    private static Instant newestModification(Path path) throws IOException {
+        try (Stream<Path> walk = Files.walk(path)) {
+            return walk.map(entry -> lastModified(entry).toInstant())
+                .max(Comparator.naturalOrder())
+                .orElse(Instant.EPOCH);
+        } catch (NoSuchFileException | UncheckedIOException e) {
+            // Renamed or removed while walking: not abandoned
+            return Instant.now();
+        }
+    }
+
+    private static FileTime lastModified(Path path) {
+        try {
+            return Files.getLastModifiedTime(path);
+        } catch (IOException e) {
+            return FileTime.from(Instant.EPOCH);
+        }
+    }
+
+    private static void writePrivate(Path path, byte[] data) throws IOException {
+        try {
+            Files.createFile(path, PosixFilePermissions.asFileAttribute(PosixFilePermissions.fromString("rw-------")));
+        } catch (UnsupportedOperationException e) {
+            Files.createFile(path);
+        }
+        Files.write(path, data);
+    }
+
+    private static void deleteRecursively(Path path) throws IOException {
+        if (!Files.exists(path)) {
+            return;
+        }
+        try (Stream<Path> walk = Files.walk(path)) {
+            for (Path entry : walk.sorted(Comparator.reverseOrder()).toList()) {
+                Files.deleteIfExists(entry);
+            }
+        }
+    }
+
+    private static String defaultInstanceId() {
+        String host;
+        try {
+            host = InetAddress.getLocalHost().getHostName();
+        } catch (IOException e) {
+            host = "localhost";
+        }
+        return host + "-" + ProcessHandle.current().pid();
+    }
+}
@@ -0,0 +1,395 @@
+package com.firmador.backend.service;
+
+import com.fasterxml.jackson.databind.ObjectMapper;
+import com.fasterxml.jackson.databind.node.ObjectNode;
+import com.firmador.backend.dto.PreflightResult;
+import com.firmador.backend.dto.SignatureRequest;
+import jakarta.annotation.PreDestroy;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+import org.springframework.beans.factory.annotation.Value;
+import org.springframework.stereotype.Service;
+
+import java.io.*;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.HexFormat;
+import java.util.LinkedHashMap;
+import java.util.Map;
+import java.util.UUID;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicInteger;
+
+/**
+ * Length-prefixed binary signing protocol used by
+ * {@code POST /api/signature/sign-stream}.
+ *
+ * Every frame is a one-byte type, a four-byte big-endian payload length and
+ * the payload. The request carries METADATA (JSON with the signature
+ * settings), CERTIFICATE (the PKCS#12 container), any number of DOCUMENT
+ * chunks and END. As soon as the certificate frame arrives its key is
+ * unlocked on a key-loader thread (a fixed pool, one per core by default, as
+ * PKCS#12 key derivation is CPU-bound), and document chunks are hashed,
+ * checked for a PDF header and spooled to a staging file while the rest of
+ * the upload is still in flight. END may carry the client's SHA-256 of the
+ * document, which is compared with the hash taken on arrival before anything
+ * is signed. Documents at or above {@code firmador.signature.lazy-threshold-mb}
+ * are signed from the staging file without being read into the heap. The
+ * response uses the same framing: RESULT chunks with the signed PDF, a
+ * SUMMARY JSON frame and END, or a single ERROR JSON frame and END.
+ */
+@Service
+public class StreamingSignatureService {
+
+    private static final Logger logger = LoggerFactory.getLogger(StreamingSignatureService.class);
+
+    public static final String CONTENT_TYPE = "application/vnd.firmador.sign-stream";
+
+    public static final int FRAME_END = 0;
+    public static final int FRAME_METADATA = 1;
+    public static final int FRAME_CERTIFICATE = 2;
+    public static final int FRAME_DOCUMENT = 3;
+    public static final int FRAME_RESULT = 4;
+    public static final int FRAME_SUMMARY = 5;
+    public static final int FRAME_ERROR = 6;
+
+    private static final int MAX_METADATA_BYTES = 64 * 1024;
+    private static final int MAX_CERTIFICATE_BYTES = 1024 * 1024;
+    private static final int MAX_CHUNK_BYTES = 4 * 1024 * 1024;
+    private static final int RESULT_CHUNK_BYTES = 64 * 1024;
+    private static final int HEADER_WINDOW = 1024;
+    private static final int SHA256_BYTES = 32;
+
+    public static class StreamSignException extends RuntimeException {
+        private final int status;
+        private final String code;
+
+        public StreamSignException(int status, String code, String message) {
+            super(message);
+            this.status = status;
+            this.code = code;
+        }
+
+        public int getStatus() { return status; }
+        public String getCode() { return code; }
+    }
+
+    /** Size of the spooled document and the SHA-256 the client sent with END, if any. */
+    private static class Upload {
+        final long size;
+        final byte[] expectedSha256;
+
+        Upload(long size, byte[] expectedSha256) {
+            this.size = size;
+            this.expectedSha256 = expectedSha256;
+        }
+    }
+
+    private final DigitalSignatureService digitalSignatureService;
+    private final PdfPreflightService pdfPreflightService;
+    private final DocumentStorageService documentStorageService;
+    private final ObjectMapper objectMapper;
+    private final long maxDocumentBytes;
+    private final ExecutorService keyLoader;
+
+    public StreamingSignatureService(DigitalSignatureService digitalSignatureService,
+                                     PdfPreflightService pdfPreflightService,
+                                     DocumentStorageService documentStorageService,
+                                     ObjectMapper objectMapper,
+                                     @Value("${firmador.security.max-file-size-mb:50}") long maxFileSizeMb,
+                                     @Value("${firmador.signature.key-loader-threads:0}") int keyLoaderThreads) {
+        this.digitalSignatureService = digitalSignatureService;
+        this.pdfPreflightService = pdfPreflightService;
+        this.documentStorageService = documentStorageService;
+        this.objectMapper = objectMapper;
+        this.maxDocumentBytes = maxFileSizeMb * 1024 * 1024;
+        int threads = keyLoaderThreads > 0 ? keyLoaderThreads : Runtime.getRuntime().availableProcessors();
+        AtomicInteger threadNumber = new AtomicInteger();
+        this.keyLoader = Executors.newFixedThreadPool(threads, runnable -> {
+            Thread thread = new Thread(runnable, "stream-key-loader-" + threadNumber.incrementAndGet());
+            thread.setDaemon(true);
+            return thread;
+        });
+    }
+
+    @PreDestroy
+    public void shutdown() {
+        keyLoader.shutdownNow();
+    }
+
+    /**
+     * Reads a framed request from {@code input} and writes the framed signed
+     * document to {@code output}. Failures detected before any output is
+     * written are thrown as {@link StreamSignException}.
+     */
+    public void sign(InputStream input, OutputStream output) throws IOException {
+        long start = System.nanoTime();
+        DataInputStream in = new DataInputStream(new BufferedInputStream(input, RESULT_CHUNK_BYTES));
+
+        // Metadata: signature settings, the filename and an optional size hint
+        ObjectNode metadata = readMetadata(in);
+        String filename = metadata.path("filename").asText("document.pdf");
+        SignatureRequest request = toSignatureRequest(metadata);
+        if (metadata.path("documentSize").asLong(0) > maxDocumentBytes) {
+            throw new StreamSignException(413, "DOCUMENT_TOO_LARGE",
+                "Document exceeds " + maxDocumentBytes + " bytes");
+        }
+
+        // Certificate: unlock the key while the document is uploading
+        expectFrame(in, FRAME_CERTIFICATE);
+        int certificateLength = readLength(in, MAX_CERTIFICATE_BYTES);
+        request.setCertificateData(in.readNBytes(certificateLength));
+        if (request.getCertificateData().length != certificateLength) {
+            throw new StreamSignException(400, "TRUNCATED_STREAM", "Stream ended inside the certificate frame");
+        }
+        Future<DigitalSignatureService.SigningKey> signingKey = keyLoader.submit(() ->
+            digitalSignatureService.loadSigningKey(request.getCertificateData(), request.getCertificatePassword()));
+
+        String stagingId = UUID.randomUUID().toString();
+        Path document = null;
+        Path signed = null;
+        try {
+            document = documentStorageService.createStagingFile(stagingId);
+            byte[] documentHash;
+            Upload upload;
+            try {
+                MessageDigest digest = MessageDigest.getInstance("SHA-256");
+                upload = readDocument(in, digest, document);
+                documentHash = digest.digest();
+            } catch (NoSuchAlgorithmException e) {
+                throw new IllegalStateException(e);
+            }
+            if (upload.expectedSha256 != null && !MessageDigest.isEqual(upload.expectedSha256, documentHash)) {
+                throw new StreamSignException(400, "DOCUMENT_HASH_MISMATCH",
+                    "Document SHA-256 does not match the hash sent by the client");
+            }
+            long uploadMillis = (System.nanoTime() - start) / 1_000_000;
+            boolean keyReadyBeforeUpload = signingKey.isDone();
+
+            PreflightResult preflight = pdfPreflightService.scan(document, request.getSignaturePage());
+            if (!preflight.isOk()) {
+                throw new StreamSignException(422, preflight.getStatus().name(), preflight.getMessage());
+            }
+
+            DigitalSignatureService.SigningKey key;
+            try {
+                key = signingKey.get();
+            } catch (ExecutionException e) {
+                throw new StreamSignException(400, "INVALID_CERTIFICATE",
+                    "Certificado inválido o contraseña incorrecta: " + e.getCause().getMessage());
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                throw new StreamSignException(503, "INTERRUPTED", "Signing interrupted");
+            }
+
+            long signStart = System.nanoTime();
+            long signedSize;
+            InputStream result;
+            if (digitalSignatureService.isLargeDocument(upload.size)) {
+                signed = documentStorageService.createStagingFile(stagingId);
+                digitalSignatureService.signPdf(document, signed, request, key);
+                signedSize = Files.size(signed);
+                result = Files.newInputStream(signed);
+            } else {
+                byte[] signedPdf = digitalSignatureService.signPdf(Files.readAllBytes(document), request, key);
+                signedSize = signedPdf.length;
+                result = new ByteArrayInputStream(signedPdf);
+            }
+            long signMillis = (System.nanoTime() - signStart) / 1_000_000;
+
+            DataOutputStream out = new DataOutputStream(new BufferedOutputStream(output, RESULT_CHUNK_BYTES));
+            try (InputStream signedPdf = result) {
+                byte[] chunk = new byte[RESULT_CHUNK_BYTES];
+                int length;
+                while ((length = signedPdf.readNBytes(chunk, 0, chunk.length)) > 0) {
+                    writeFrame(out, FRAME_RESULT, chunk, 0, length);
+                }
+            }
+
+            Map<String, Object> summary = new LinkedHashMap<>();
+            summary.put("filename", filename.replaceFirst("(\\.[^.]*)?$", "_signed$1"));
+            summary.put("documentSha256", HexFormat.of().formatHex(documentHash));
+            summary.put("documentSha256Verified", upload.expectedSha256 != null);
+            summary.put("originalSize", upload.size);
+            summary.put("signedSize", signedSize);
+            summary.put("uploadMillis", uploadMillis);
+            summary.put("signMillis", signMillis);
+            summary.put("keyReadyBeforeUpload", keyReadyBeforeUpload);
+            byte[] summaryJson = objectMapper.writeValueAsBytes(summary);
+            writeFrame(out, FRAME_SUMMARY, summaryJson, 0, summaryJson.length);
+            writeFrame(out, FRAME_END, summaryJson, 0, 0);
+            out.flush();
+
+            logger.info("Streamed signature of {} ({} bytes): upload {} ms, sign {} ms, key ready early: {}",
+                filename, upload.size, uploadMillis, signMillis, keyReadyBeforeUpload);
+        } finally {
+            signingKey.cancel(true);
+            deleteQuietly(document);
+            deleteQuietly(signed);
+        }
+    }
+
+    public void writeError(OutputStream output, StreamSignException error) throws IOException {
+        DataOutputStream out = new DataOutputStream(output);
+        byte[] body = objectMapper.writeValueAsBytes(Map.of(
+            "error", error.getMessage(),
+            "code", error.getCode()));
+        writeFrame(out, FRAME_ERROR, body, 0, body.length);
+        writeFrame(out, FRAME_END, body, 0, 0);
+        out.flush();
+    }
+
+    private ObjectNode readMetadata(DataInputStream in) throws IOException {
+        expectFrame(in, FRAME_METADATA);
+        int length = readLength(in, MAX_METADATA_BYTES);
+        byte[] json = in.readNBytes(length);
+        if (json.length != length) {
+            throw new StreamSignException(400, "TRUNCATED_STREAM", "Stream ended inside the metadata frame");
+        }
+        try {
+            return (ObjectNode) objectMapper.readTree(new String(json, StandardCharsets.UTF_8));
+        } catch (IOException | ClassCastException e) {
+            throw new StreamSignException(400, "INVALID_METADATA", "Metadata frame must be a JSON object");
+        }
+    }
+
+    private SignatureRequest toSignatureRequest(ObjectNode metadata) throws IOException {
+        for (String field : new String[] {"signerName", "signerId", "location", "reason", "certificatePassword"}) {
+            if (metadata.path(field).asText("").isBlank()) {
+                throw new StreamSignException(400, "INVALID_METADATA", "Missing metadata field: " + field);
+            }
+        }
+        ObjectNode settings = metadata.deepCopy();
+        settings.remove("filename");
+        settings.remove("documentSize");
+        settings.remove("certificateData");
+        try {
+            return objectMapper.treeToValue(settings, SignatureRequest.class);
+        } catch (IOException e) {
+            throw new StreamSignException(400, "INVALID_METADATA", "Invalid metadata: " + e.getMessage());
+        }
+    }
+
+    /**
+     * Spools DOCUMENT chunks up to END into {@code document}, hashing them as
+     * they arrive and rejecting non-PDF input as soon as the header window is
+     * complete. Only the header window is kept in memory.
+     */
+    private Upload readDocument(DataInputStream in, MessageDigest digest, Path document) throws IOException {
+        byte[] buffer = new byte[RESULT_CHUNK_BYTES];
+        byte[] header = new byte[HEADER_WINDOW];
+        int headerLength = 0;
+        boolean headerChecked = false;
+        long size = 0;
+
+        try (OutputStream spool = Files.newOutputStream(document)) {
+            while (true) {
+                int type = readType(in);
+                if (type == FRAME_END) {
+                    if (!headerChecked) {
+                        checkHeader(header, headerLength);
+                    }
+                    return new Upload(size, readExpectedHash(in));
+                }
+                if (type != FRAME_DOCUMENT) {
+                    throw new StreamSignException(400, "UNEXPECTED_FRAME", "Unexpected frame type " + type);
+                }
+                int remaining = readLength(in, MAX_CHUNK_BYTES);
+                if (size + remaining > maxDocumentBytes) {
+                    throw new StreamSignException(413, "DOCUMENT_TOO_LARGE",
+                        "Document exceeds " + maxDocumentBytes + " bytes");
+                }
+                while (remaining > 0) {
+                    int read = in.read(buffer, 0, Math.min(buffer.length, remaining));
+                    if (read < 0) {
+                        throw new StreamSignException(400, "TRUNCATED_STREAM", "Stream ended inside a document frame");
+                    }
+                    digest.update(buffer, 0, read);
+                    spool.write(buffer, 0, read);
+                    if (headerLength < HEADER_WINDOW) {
+                        int copied = Math.min(read, HEADER_WINDOW - headerLength);
+                        System.arraycopy(buffer, 0, header, headerLength, copied);
+                        headerLength += copied;
+                    }
+                    size += read;
+                    remaining -= read;
+                }
+                if (!headerChecked && headerLength == HEADER_WINDOW) {
+                    checkHeader(header, headerLength);
+                    headerChecked = true;
+                }
+            }
+        }
+    }
+
+    /** END carries either nothing or the client's SHA-256 of the document. */
+    private byte[] readExpectedHash(DataInputStream in) throws IOException {
+        int length = readLength(in, SHA256_BYTES);
+        if (length == 0) {
+            return null;
+        }
+        byte[] hash = in.readNBytes(length);
+        if (length != SHA256_BYTES || hash.length != SHA256_BYTES) {
+            throw new StreamSignException(400, "INVALID_END_FRAME",
+                "END frame must be empty or carry a " + SHA256_BYTES + "-byte SHA-256");
+        }
+        return hash;
+    }
+
+    private void checkHeader(byte[] header, int length) {
+        String head = new String(header, 0, length, StandardCharsets.ISO_8859_1);
+        if (!head.contains("%PDF-")) {
+            throw new StreamSignException(422, PreflightResult.Status.NOT_PDF.name(), "Missing %PDF- header");
+        }
+    }
+
+    private static void deleteQuietly(Path path) {
+        if (path == null) {
+            return;
+        }
+        try {
+            Files.deleteIfExists(path);
+        } catch (IOException e) {
+            logger.warn("Could not delete staging file {}: {}", path, e.getMessage());
+        }
+    }
+
+    private void expectFrame(DataInputStream in, int expected) throws IOException {
+        int type = readType(in);
+        if (type != expected) {
+            throw new StreamSignException(400, "UNEXPECTED_FRAME",
+                "Expected frame type " + expected + " but got " + type);
+        }
+    }
+
+    private int readType(DataInputStream in) throws IOException {
+        int type = in.read();
+        if (type < 0) {
+            throw new StreamSignException(400, "TRUNCATED_STREAM", "Stream ended before the END frame");
+        }
+        return type;
+    }
+
+    private int readLength(DataInputStream in, int max) throws IOException {
+        int length;
+        try {
+            length = in.readInt();
+        } catch (EOFException e) {
+            throw new StreamSignException(400, "TRUNCATED_STREAM", "Stream ended inside a frame header");
+        }
+        if (length < 0 || length > max) {
+            throw new StreamSignException(400, "FRAME_TOO_LARGE", "Frame length " + length + " exceeds " + max);
+        }
+        return length;
+    }
+
+    private static void writeFrame(DataOutputStream out, int type, byte[] payload, int offset, int length)
+            throws IOException {
+        out.writeByte(type);
+        out.writeInt(length);
+        out.write(payload, offset, length);
+    }
+}
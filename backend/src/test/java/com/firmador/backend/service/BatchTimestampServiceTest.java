@@ -0,0 +1,370 @@
+package com.firmador.backend.service;
+
+import com.sun.net.httpserver.HttpServer;
+import org.bouncycastle.asn1.ASN1ObjectIdentifier;
+import org.bouncycastle.asn1.oiw.OIWObjectIdentifiers;
+import org.bouncycastle.asn1.x500.X500Name;
+import org.bouncycastle.asn1.x509.AlgorithmIdentifier;
+import org.bouncycastle.asn1.x509.BasicConstraints;
+import org.bouncycastle.asn1.x509.ExtendedKeyUsage;
+import org.bouncycastle.asn1.x509.Extension;
+import org.bouncycastle.asn1.x509.KeyPurposeId;
+import org.bouncycastle.asn1.x509.KeyUsage;
+import org.bouncycastle.cert.X509v3CertificateBuilder;
+import org.bouncycastle.cert.jcajce.JcaCertStore;
+import org.bouncycastle.cert.jcajce.JcaX509CertificateConverter;
+import org.bouncycastle.cert.jcajce.JcaX509v3CertificateBuilder;
+import org.bouncycastle.jce.provider.BouncyCastleProvider;
+import org.bouncycastle.operator.jcajce.JcaContentSignerBuilder;
+import org.bouncycastle.operator.jcajce.JcaDigestCalculatorProviderBuilder;
+import org.bouncycastle.cms.jcajce.JcaSimpleSignerInfoGeneratorBuilder;
+import org.bouncycastle.tsp.TSPAlgorithms;
+import org.bouncycastle.tsp.TimeStampRequest;
+import org.bouncycastle.tsp.TimeStampResponseGenerator;
+import org.bouncycastle.tsp.TimeStampTokenGenerator;
+import org.junit.jupiter.api.AfterAll;
+import org.junit.jupiter.api.BeforeAll;
+import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.io.OutputStream;
+import java.math.BigInteger;
+import java.net.InetSocketAddress;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.KeyStore;
+import java.security.MessageDigest;
+import java.security.PrivateKey;
+import java.security.Security;
+import java.security.cert.X509Certificate;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Date;
+import java.util.List;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+class BatchTimestampServiceTest {
+
+    private static final String PASSWORD = "changeit";
+
+    @TempDir
+    static Path tempDir;
+
+    private static HttpServer tsa;
+    private static final long HANG_MILLIS = 3_000;
+
+    private static String tsaUrl;
+    private static String hangUrl;
+    private static final AtomicInteger tsaRequests = new AtomicInteger();
+    private static final AtomicInteger serials = new AtomicInteger();
+    private static X509Certificate tsaCertificate;
+    private static Path trustStore;
+    private static Path foreignTrustStore;
+
+    @BeforeAll
+    static void startTsa() throws Exception {
+        Security.addProvider(new BouncyCastleProvider());
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("RSA");
+        generator.initialize(2048);
+
+        KeyPair caKeys = generator.generateKeyPair();
+        X509Certificate ca = certificate("CN=Test CA", caKeys, "CN=Test CA", caKeys.getPrivate(), true);
+        KeyPair tsaKeys = generator.generateKeyPair();
+        tsaCertificate = certificate("CN=Test TSA", tsaKeys, "CN=Test CA", caKeys.getPrivate(), false);
+        KeyPair foreignKeys = generator.generateKeyPair();
+        X509Certificate foreignCa = certificate("CN=Other CA", foreignKeys, "CN=Other CA", foreignKeys.getPrivate(), true);
+
+        trustStore = writeTrustStore("trusted.p12", ca);
+        foreignTrustStore = writeTrustStore("foreign.p12", foreignCa);
+
+        TimeStampTokenGenerator tokenGenerator = new TimeStampTokenGenerator(
+            new JcaSimpleSignerInfoGeneratorBuilder().setProvider("BC")
+                .build("SHA256withRSA", tsaKeys.getPrivate(), tsaCertificate),
+            new JcaDigestCalculatorProviderBuilder().build().get(new AlgorithmIdentifier(OIWObjectIdentifiers.idSHA1)),
+            new ASN1ObjectIdentifier("1.2.3.4.1"));
+        tokenGenerator.addCertificates(new JcaCertStore(List.of(tsaCertificate, ca)));
+        TimeStampResponseGenerator responseGenerator = new TimeStampResponseGenerator(tokenGenerator, TSPAlgorithms.ALLOWED);
+
+        tsa = HttpServer.create(new InetSocketAddress("127.0.0.1", 0), 0);
+        tsa.createContext("/tsa", exchange -> {
+            try {
+                tsaRequests.incrementAndGet();
+                TimeStampRequest request = new TimeStampRequest(exchange.getRequestBody().readAllBytes());
+                byte[] response = responseGenerator.generate(request,
+                    BigInteger.valueOf(tsaRequests.get()), new Date()).getEncoded();
+                exchange.getResponseHeaders().add("Content-Type", "application/timestamp-reply");
+                exchange.sendResponseHeaders(200, response.length);
+                try (OutputStream out = exchange.getResponseBody()) {
+                    out.write(response);
+                }
+            } catch (Exception e) {
+                exchange.sendResponseHeaders(500, -1);
+                exchange.close();
+            }
+        });
+        // Accepts the connection, then never answers in time
+        tsa.createContext("/hang", exchange -> {
+            try {
+                Thread.sleep(HANG_MILLIS);
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+            }
+            exchange.sendResponseHeaders(500, -1);
+            exchange.close();
+        });
+        tsa.setExecutor(Executors.newCachedThreadPool());
+        tsa.start();
+        tsaUrl = "http://127.0.0.1:" + tsa.getAddress().getPort() + "/tsa";
+        hangUrl = "http://127.0.0.1:" + tsa.getAddress().getPort() + "/hang";
+    }
+
+    @AfterAll
+    static void stopTsa() {
+        tsa.stop(0);
+    }
+
+    @Test
+    void buildsTreeWithRootOverAllLeaves() throws Exception {
+        List<byte[]> hashes = hashes(5);
+        List<List<byte[]>> levels = BatchTimestampService.buildTree(hashes);
+
+        assertEquals(List.of(5, 3, 2, 1), levels.stream().map(List::size).toList());
+        byte[] left = BatchTimestampService.hashGroup(List.of(
+            BatchTimestampService.hashGroup(List.of(hashes.get(0), hashes.get(1))),
+            BatchTimestampService.hashGroup(List.of(hashes.get(2), hashes.get(3)))));
+        byte[] right = BatchTimestampService.hashGroup(List.of(
+            BatchTimestampService.hashGroup(List.of(hashes.get(4)))));
+        assertArrayEquals(BatchTimestampService.hashGroup(List.of(left, right)), levels.get(3).get(0));
+    }
+
+    @Test
+    void proofStoresLeafOnlyInFirstGroupAndSiblingsAbove() throws Exception {
+        List<byte[]> hashes = hashes(5);
+        List<List<byte[]>> levels = BatchTimestampService.buildTree(hashes);
+
+        List<List<byte[]>> proof = BatchTimestampService.proof(levels, 2);
+        assertEquals(3, proof.size());
+        assertEquals(List.of(hashes.get(2), hashes.get(3)), proof.get(0));
+        assertEquals(List.of(levels.get(1).get(0)), proof.get(1));
+        assertEquals(List.of(levels.get(2).get(1)), proof.get(2));
+
+        // The odd leaf has no sibling on levels 0 and 1
+        List<List<byte[]>> lone = BatchTimestampService.proof(levels, 4);
+        assertEquals(List.of(hashes.get(4)), lone.get(0));
+        assertTrue(lone.get(1).isEmpty());
+        assertEquals(List.of(levels.get(2).get(0)), lone.get(2));
+    }
+
+    @Test
+    void verifiesEveryDocumentOfABatch() throws Exception {
+        BatchTimestampService service = service(trustStore);
+        try {
+            for (int size : new int[] {1, 2, 3, 8}) {
+                List<byte[]> hashes = hashes(size);
+                int before = tsaRequests.get();
+                List<byte[]> records = timestampAll(service, hashes);
+
+                assertEquals(before + 1, tsaRequests.get(), "one TSA request per batch of " + size);
+                for (int i = 0; i < size; i++) {
+                    BatchTimestampService.Verification verification = service.verify(hashes.get(i), records.get(i));
+                    assertTrue(verification.isValid(), verification.getMessage());
+                    assertEquals(tsaCertificate.getSubjectX500Principal().getName(), verification.getTsaSubject());
+                    assertEquals("CN=Test CA", verification.getTsaIssuer());
+                    assertNotNull(verification.getTimestamp());
+                }
+            }
+        } finally {
+            service.shutdown();
+        }
+    }
+
+    @Test
+    void rejectsHashOutsideTheBatch() throws Exception {
+        BatchTimestampService service = service(trustStore);
+        try {
+            List<byte[]> hashes = hashes(4);
+            List<byte[]> records = timestampAll(service, hashes);
+
+            assertFalse(service.verify(hashes.get(1), records.get(0)).isValid());
+            assertFalse(service.verify(hashes(5).get(4), records.get(0)).isValid());
+        } finally {
+            service.shutdown();
+        }
+    }
+
+    @Test
+    void rejectsTamperedEvidenceRecord() throws Exception {
+        BatchTimestampService service = service(trustStore);
+        try {
+            List<byte[]> hashes = hashes(2);
+            byte[] record = timestampAll(service, hashes).get(0);
+
+            // The sibling hash inside the reduced tree
+            byte[] sibling = record.clone();
+            int offset = indexOf(sibling, hashes.get(1));
+            sibling[offset] ^= 1;
+            assertFalse(service.verify(hashes.get(0), sibling).isValid());
+
+            // The TSA signature value closes the encoding
+            byte[] signature = record.clone();
+            signature[signature.length - 1] ^= 1;
+            assertFalse(service.verify(hashes.get(0), signature).isValid());
+        } finally {
+            service.shutdown();
+        }
+    }
+
+    @Test
+    void rejectsTsaOutsideTrustStore() throws Exception {
+        BatchTimestampService service = service(trustStore);
+        BatchTimestampService foreign = service(foreignTrustStore);
+        try {
+            List<byte[]> hashes = hashes(1);
+            byte[] record = timestampAll(service, hashes).get(0);
+
+            BatchTimestampService.Verification verification = foreign.verify(hashes.get(0), record);
+            assertFalse(verification.isValid());
+            assertTrue(verification.getMessage().contains("no es de confianza"), verification.getMessage());
+        } finally {
+            service.shutdown();
+            foreign.shutdown();
+        }
+    }
+
+    @Test
+    void fallsBackWhenBatchTsaDoesNotAnswer() throws Exception {
+        BatchTimestampService service = new BatchTimestampService(100, 1024, 10_000, 300,
+                trustStore.toString(), PASSWORD, "PKCS12") {
+            @Override
+            List<String> tsaServers(String primaryUrl) {
+                return List.of(primaryUrl, tsaUrl);
+            }
+        };
+        try {
+            List<byte[]> hashes = hashes(2);
+            long start = System.currentTimeMillis();
+            List<byte[]> records = timestampAll(service, hashes, hangUrl);
+
+            assertTrue(System.currentTimeMillis() - start < HANG_MILLIS, "waited for the unresponsive TSA");
+            for (int i = 0; i < hashes.size(); i++) {
+                assertTrue(service.verify(hashes.get(i), records.get(i)).isValid());
+            }
+        } finally {
+            service.shutdown();
+        }
+    }
+
+    @Test
+    void unresponsiveTsaDoesNotDelayOtherWindows() throws Exception {
+        BatchTimestampService service = new BatchTimestampService(100, 1024, 2_000, 2_000,
+                trustStore.toString(), PASSWORD, "PKCS12") {
+            @Override
+            List<String> tsaServers(String primaryUrl) {
+                return List.of(primaryUrl);
+            }
+        };
+        ExecutorService stuck = Executors.newFixedThreadPool(3);
+        try {
+            // More stuck batches than the old two-thread scheduler had threads
+            List<Future<byte[]>> hung = new ArrayList<>();
+            for (int i = 0; i < 3; i++) {
+                byte[] hash = hashes(i + 1).get(i);
+                String url = hangUrl + "?batch=" + i;
+                hung.add(stuck.submit(() -> service.timestamp(hash, url)));
+            }
+            Thread.sleep(300);
+
+            long start = System.currentTimeMillis();
+            List<byte[]> hashes = hashes(1);
+            byte[] record = timestampAll(service, hashes, tsaUrl).get(0);
+            assertTrue(System.currentTimeMillis() - start < 1_000, "window timer waited behind a stuck TSA");
+            assertTrue(service.verify(hashes.get(0), record).isValid());
+
+            // Each fails on its own timeout rather than blocking forever
+            for (Future<byte[]> request : hung) {
+                assertThrows(ExecutionException.class, request::get);
+            }
+        } finally {
+            stuck.shutdownNow();
+            service.shutdown();
+        }
+    }
+
+    private static BatchTimestampService service(Path trustStore) throws Exception {
+        return new BatchTimestampService(300, 1024, 10_000, 10_000, trustStore.toString(), PASSWORD, "PKCS12");
+    }
+
+    private static List<byte[]> timestampAll(BatchTimestampService service, List<byte[]> hashes) throws Exception {
+        return timestampAll(service, hashes, tsaUrl);
+    }
+
+    private static List<byte[]> timestampAll(BatchTimestampService service, List<byte[]> hashes, String url)
+            throws Exception {
+        ExecutorService signers = Executors.newFixedThreadPool(hashes.size());
+        try {
+            List<Future<byte[]>> pending = new ArrayList<>();
+            for (byte[] hash : hashes) {
+                pending.add(signers.submit(() -> service.timestamp(hash, url)));
+            }
+            List<byte[]> records = new ArrayList<>();
+            for (Future<byte[]> record : pending) {
+                records.add(record.get());
+            }
+            return records;
+        } finally {
+            signers.shutdownNow();
+        }
+    }
+
+    private static List<byte[]> hashes(int count) throws Exception {
+        List<byte[]> hashes = new ArrayList<>();
+        for (int i = 0; i < count; i++) {
+            hashes.add(MessageDigest.getInstance("SHA-256").digest(("document " + i).getBytes()));
+        }
+        return hashes;
+    }
+
+    private static int indexOf(byte[] haystack, byte[] needle) {
+        for (int i = 0; i + needle.length <= haystack.length; i++) {
+            if (Arrays.equals(haystack, i, i + needle.length, needle, 0, needle.length)) {
+                return i;
+            }
+        }
+        throw new AssertionError("hash not found in evidence record");
+    }
+
+    private static X509Certificate certificate(String subject, KeyPair keys, String issuer,
+                                               PrivateKey issuerKey, boolean authority) throws Exception {
+        long now = System.currentTimeMillis();
+        X509v3CertificateBuilder builder = new JcaX509v3CertificateBuilder(
+            new X500Name(issuer), BigInteger.valueOf(serials.incrementAndGet()), new Date(now - 3_600_000L),
+            new Date(now + 86_400_000L), new X500Name(subject), keys.getPublic());
+        if (authority) {
+            builder.addExtension(Extension.basicConstraints, true, new BasicConstraints(true));
+            builder.addExtension(Extension.keyUsage, true, new KeyUsage(KeyUsage.keyCertSign));
+        } else {
+            builder.addExtension(Extension.extendedKeyUsage, true, new ExtendedKeyUsage(KeyPurposeId.id_kp_timeStamping));
+        }
+        return new JcaX509CertificateConverter().setProvider("BC").getCertificate(
+            builder.build(new JcaContentSignerBuilder("SHA256withRSA").setProvider("BC").build(issuerKey)));
+    }
+
+    private static Path writeTrustStore(String name, X509Certificate anchor) throws Exception {
+        KeyStore keyStore = KeyStore.getInstance("PKCS12");
+        keyStore.load(null, null);
+        keyStore.setCertificateEntry("ca", anchor);
+        Path path = tempDir.resolve(name);
+        try (OutputStream out = Files.newOutputStream(path)) {
+            keyStore.store(out, PASSWORD.toCharArray());
+        }
+        return path;
+    }
+}
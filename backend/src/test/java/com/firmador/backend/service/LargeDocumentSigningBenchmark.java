@@ -0,0 +1,208 @@
+package com.firmador.backend.service;
+
+import com.firmador.backend.dto.SignatureRequest;
+import com.itextpdf.kernel.pdf.PdfDocument;
+import com.itextpdf.kernel.pdf.PdfReader;
+import com.itextpdf.kernel.pdf.PdfWriter;
+import com.itextpdf.layout.Document;
+import com.itextpdf.layout.element.AreaBreak;
+import com.itextpdf.layout.element.Paragraph;
+import org.bouncycastle.asn1.x500.X500Name;
+import org.bouncycastle.cert.jcajce.JcaX509CertificateConverter;
+import org.bouncycastle.cert.jcajce.JcaX509v3CertificateBuilder;
+import org.bouncycastle.jce.provider.BouncyCastleProvider;
+import org.bouncycastle.operator.jcajce.JcaContentSignerBuilder;
+import org.junit.jupiter.api.BeforeAll;
+import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.lang.management.ManagementFactory;
+import java.lang.management.MemoryPoolMXBean;
+import java.lang.management.MemoryType;
+import java.math.BigInteger;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.KeyStore;
+import java.security.Security;
+import java.security.cert.Certificate;
+import java.util.Date;
+import java.util.List;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * Time and heap of the in-memory and the lazy (file-backed, append mode)
+ * paths on a generated 5,000-page document. {@code compareInMemoryAndLazyParsing}
+ * only opens a PdfReader/PdfDocument from a byte array and from the file path,
+ * isolating the cost of the parse itself; {@code compareInMemoryAndLazySigning}
+ * times the whole signing call, where full rewrite versus append mode also
+ * counts. Not part of the default test run (surefire only picks up *Test
+ * classes); run with
+ *
+ *   mvn test -Dtest=LargeDocumentSigningBenchmark
+ *
+ * Heap is reported as bytes allocated by the signing thread and as the peak
+ * of the heap pools during the call, both after a full GC.
+ */
+class LargeDocumentSigningBenchmark {
+
+    private static final int PAGES = 5_000;
+    private static final int ROUNDS = 3;
+    private static final String PASSWORD = "benchmark";
+
+    @TempDir
+    static Path tempDir;
+
+    private static Path document;
+    private static byte[] certificate;
+    private static DigitalSignatureService service;
+
+    @BeforeAll
+    static void setUp() throws Exception {
+        Security.addProvider(new BouncyCastleProvider());
+        document = tempDir.resolve("large.pdf");
+        try (Document layout = new Document(new PdfDocument(new PdfWriter(document.toString())))) {
+            for (int page = 1; page <= PAGES; page++) {
+                if (page > 1) {
+                    layout.add(new AreaBreak());
+                }
+                layout.add(new Paragraph("Página " + page + " de " + PAGES + ". " + "Contenido de relleno. ".repeat(40)));
+            }
+        }
+        certificate = selfSignedPkcs12();
+
+        SignatureProviderSelector providers = new SignatureProviderSelector(
+            List.of("BC"), false, "", false, List.of(2048), 1, 0, 0);
+        providers.select();
+        service = new DigitalSignatureService(new CertificateService(), null, providers, 16);
+    }
+
+    @Test
+    void compareInMemoryAndLazyParsing() throws Exception {
+        System.out.printf("%d pages, %d MB%n", PAGES, Files.size(document) >> 20);
+        System.out.printf("%-10s %10s %14s %12s%n", "open", "millis", "allocated MB", "peak MB");
+
+        Measurement eager = null;
+        Measurement lazy = null;
+        // Round 0 warms up the JIT and is not reported
+        for (int round = 0; round <= ROUNDS; round++) {
+            Measurement fromBytes = measure(() -> {
+                byte[] pdfBytes = Files.readAllBytes(document);
+                try (PdfDocument pdf = new PdfDocument(new PdfReader(new ByteArrayInputStream(pdfBytes)))) {
+                    assertEquals(PAGES, pdf.getNumberOfPages());
+                }
+            });
+            Measurement fromPath = measure(() -> {
+                try (PdfDocument pdf = new PdfDocument(new PdfReader(document.toString()))) {
+                    assertEquals(PAGES, pdf.getNumberOfPages());
+                }
+            });
+
+            if (round > 0) {
+                fromBytes.print("bytes");
+                fromPath.print("path");
+                eager = fromBytes;
+                lazy = fromPath;
+            }
+        }
+
+        assertTrue(lazy.allocatedBytes < eager.allocatedBytes,
+            "opening from the path should allocate less than from a byte array");
+    }
+
+    @Test
+    void compareInMemoryAndLazySigning() throws Exception {
+        System.out.printf("%d pages, %d MB%n", PAGES, Files.size(document) >> 20);
+        System.out.printf("%-10s %10s %14s %12s%n", "path", "millis", "allocated MB", "peak MB");
+
+        Measurement eager = null;
+        Measurement lazy = null;
+        // Round 0 warms up the JIT and is not reported
+        for (int round = 0; round <= ROUNDS; round++) {
+            Measurement inMemory = measure(() -> service.signPdf(Files.readAllBytes(document), request()));
+            Path output = tempDir.resolve("signed-" + round + ".pdf");
+            Measurement fromDisk = measure(() -> service.signPdf(document, output, request()));
+            assertTrue(Files.size(output) > Files.size(document));
+            Files.delete(output);
+
+            if (round > 0) {
+                inMemory.print("in-memory");
+                fromDisk.print("lazy");
+                eager = inMemory;
+                lazy = fromDisk;
+            }
+        }
+
+        assertTrue(lazy.allocatedBytes < eager.allocatedBytes,
+            "lazy path should allocate less than the in-memory path");
+    }
+
+    private static SignatureRequest request() {
+        SignatureRequest request = new SignatureRequest();
+        request.setSignerName("Benchmark");
+        request.setSignerId("0000000000");
+        request.setLocation("Quito");
+        request.setReason("Benchmark");
+        request.setCertificateData(certificate);
+        request.setCertificatePassword(PASSWORD);
+        return request;
+    }
+
+    @FunctionalInterface
+    private interface Body {
+        void run() throws Exception;
+    }
+
+    private static class Measurement {
+        long millis;
+        long allocatedBytes;
+        long peakHeapBytes;
+
+        void print(String label) {
+            System.out.printf("%-10s %10d %14d %12d%n", label, millis, allocatedBytes >> 20, peakHeapBytes >> 20);
+        }
+    }
+
+    private static Measurement measure(Body body) throws Exception {
+        com.sun.management.ThreadMXBean threads = (com.sun.management.ThreadMXBean) ManagementFactory.getThreadMXBean();
+        List<MemoryPoolMXBean> heapPools = ManagementFactory.getMemoryPoolMXBeans().stream()
+            .filter(pool -> pool.getType() == MemoryType.HEAP)
+            .toList();
+
+        System.gc();
+        heapPools.forEach(MemoryPoolMXBean::resetPeakUsage);
+        long threadId = Thread.currentThread().getId();
+        long allocatedBefore = threads.getThreadAllocatedBytes(threadId);
+        long start = System.nanoTime();
+        body.run();
+
+        Measurement measurement = new Measurement();
+        measurement.millis = (System.nanoTime() - start) / 1_000_000;
+        measurement.allocatedBytes = threads.getThreadAllocatedBytes(threadId) - allocatedBefore;
+        measurement.peakHeapBytes = heapPools.stream().mapToLong(pool -> pool.getPeakUsage().getUsed()).sum();
+        return measurement;
+    }
+
+    private static byte[] selfSignedPkcs12() throws Exception {
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("RSA");
+        generator.initialize(2048);
+        KeyPair keys = generator.generateKeyPair();
+        long now = System.currentTimeMillis();
+        X500Name name = new X500Name("CN=Benchmark");
+        Certificate self = new JcaX509CertificateConverter().setProvider("BC").getCertificate(
+            new JcaX509v3CertificateBuilder(name, BigInteger.ONE, new Date(now - 3_600_000L),
+                new Date(now + 86_400_000L), name, keys.getPublic())
+                .build(new JcaContentSignerBuilder("SHA256withRSA").setProvider("BC").build(keys.getPrivate())));
+
+        KeyStore keyStore = KeyStore.getInstance("PKCS12");
+        keyStore.load(null, null);
+        keyStore.setKeyEntry("benchmark", keys.getPrivate(), PASSWORD.toCharArray(), new Certificate[] {self});
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        keyStore.store(out, PASSWORD.toCharArray());
+        return out.toByteArray();
+    }
+}
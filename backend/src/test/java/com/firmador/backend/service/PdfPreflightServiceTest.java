@@ -0,0 +1,346 @@
+package com.firmador.backend.service;
+
+import com.firmador.backend.dto.PreflightResult;
+import org.junit.jupiter.api.Test;
+
+import java.io.ByteArrayOutputStream;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.Map;
+import java.util.zip.Deflater;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+class PdfPreflightServiceTest {
+
+    private static final String CATALOG = "<< /Type /Catalog /Pages 2 0 R >>";
+    private static final String ONE_PAGE = "<< /Type /Pages /Kids [3 0 R] /Count 1 >>";
+    private static final String PAGE = "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] >>";
+
+    private final PdfPreflightService service = new PdfPreflightService();
+
+    @Test
+    void acceptsWellFormedDocument() {
+        PreflightResult result = service.scan(onePageDocument().build(), 1);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals("1.7", result.getPdfVersion());
+        assertEquals(Integer.valueOf(1), result.getPageCount());
+        assertFalse(result.isEncrypted());
+        assertFalse(result.isHasExistingSignatures());
+    }
+
+    @Test
+    void rejectsFileWithoutPdfHeader() {
+        PreflightResult result = service.scan("just some text".getBytes(StandardCharsets.ISO_8859_1), 1);
+
+        assertEquals(PreflightResult.Status.NOT_PDF, result.getStatus());
+    }
+
+    @Test
+    void resolvesOffsetsRelativeToHeaderAfterLeadingJunk() {
+        PdfBuilder pdf = new PdfBuilder("garbage before the header\n")
+            .object(1, CATALOG)
+            .object(2, ONE_PAGE)
+            .object(3, PAGE)
+            .xref("/Size 4 /Root 1 0 R");
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals(Integer.valueOf(1), result.getPageCount());
+    }
+
+    @Test
+    void rejectsTruncatedDocument() {
+        byte[] pdf = onePageDocument().build();
+
+        PreflightResult result = service.scan(Arrays.copyOf(pdf, pdf.length / 2), 1);
+
+        assertEquals(PreflightResult.Status.TRUNCATED, result.getStatus());
+    }
+
+    @Test
+    void toleratesJunkAfterEofBeyondTailWindow() {
+        PdfBuilder pdf = onePageDocument().append("x".repeat(20_000));
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals(Integer.valueOf(1), result.getPageCount());
+    }
+
+    @Test
+    void rejectsStartxrefPastEndOfFile() {
+        String pdf = "%PDF-1.7\n1 0 obj\n" + CATALOG + "\nendobj\nstartxref\n999999\n%%EOF\n";
+
+        PreflightResult result = service.scan(pdf.getBytes(StandardCharsets.ISO_8859_1), 1);
+
+        assertEquals(PreflightResult.Status.BROKEN_XREF, result.getStatus());
+    }
+
+    @Test
+    void rejectsStartxrefNotPointingAtCrossReference() {
+        // Offset 0 is the header, offset 9 an ordinary object
+        for (String offset : new String[] {"0", "9"}) {
+            String pdf = "%PDF-1.7\n1 0 obj\n" + CATALOG + "\nendobj\nstartxref\n" + offset + "\n%%EOF\n";
+
+            PreflightResult result = service.scan(pdf.getBytes(StandardCharsets.ISO_8859_1), 1);
+
+            assertEquals(PreflightResult.Status.BROKEN_XREF, result.getStatus(), "startxref " + offset);
+        }
+    }
+
+    @Test
+    void rejectsUnparseableXrefTable() {
+        String pdf = "%PDF-1.7\nxref\n0 one\ntrailer\n<< /Size 1 >>\nstartxref\n9\n%%EOF\n";
+
+        PreflightResult result = service.scan(pdf.getBytes(StandardCharsets.ISO_8859_1), 1);
+
+        assertEquals(PreflightResult.Status.BROKEN_XREF, result.getStatus());
+    }
+
+    @Test
+    void rejectsEncryptedDocument() {
+        PdfBuilder pdf = new PdfBuilder("")
+            .object(1, CATALOG)
+            .object(2, ONE_PAGE)
+            .object(3, PAGE)
+            .xref("/Size 4 /Root 1 0 R /Encrypt 4 0 R");
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.ENCRYPTED, result.getStatus());
+        assertTrue(result.isEncrypted());
+    }
+
+    @Test
+    void resolvesPageTreeThroughXrefStream() {
+        PdfBuilder pdf = new PdfBuilder("")
+            .object(1, CATALOG)
+            .object(2, ONE_PAGE)
+            .object(3, PAGE)
+            .xrefStream(4, "/Root 1 0 R", false);
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals(Integer.valueOf(1), result.getPageCount());
+        assertEquals(PreflightResult.Status.PAGE_OUT_OF_RANGE, service.scan(pdf.build(), 2).getStatus());
+    }
+
+    @Test
+    void resolvesCompressedObjectsThroughPredictedXrefStream() {
+        PdfBuilder pdf = new PdfBuilder("")
+            .objectStream(5, 1, "<< /Type /Catalog /Pages 2 0 R /AcroForm 4 0 R >>", ONE_PAGE)
+            .object(3, PAGE)
+            .object(4, "<< /Fields [] /SigFlags 3 >>")
+            .xrefStream(6, "/Root 1 0 R", true);
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals(Integer.valueOf(1), result.getPageCount());
+        assertTrue(result.isHasExistingSignatures());
+    }
+
+    @Test
+    void detectsEncryptionDeclaredInXrefStream() {
+        PdfBuilder pdf = new PdfBuilder("")
+            .object(1, CATALOG)
+            .xrefStream(2, "/Root 1 0 R /Encrypt 5 0 R", false);
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.ENCRYPTED, result.getStatus());
+    }
+
+    @Test
+    void rejectsPageOutsideDocument() {
+        byte[] pdf = onePageDocument().build();
+
+        assertEquals(PreflightResult.Status.PAGE_OUT_OF_RANGE, service.scan(pdf, 2).getStatus());
+        assertEquals(PreflightResult.Status.PAGE_OUT_OF_RANGE, service.scan(pdf, 0).getStatus());
+    }
+
+    @Test
+    void prefersPageTreeOverStaleLinearizationCount() {
+        // Linearized with one page, then an incremental update adds two more
+        PdfBuilder pdf = new PdfBuilder("")
+            .object(10, "<< /Linearized 1 /L 1000 /N 1 /T 900 >>")
+            .object(1, CATALOG)
+            .object(2, ONE_PAGE)
+            .object(3, PAGE)
+            .xref("/Size 11 /Root 1 0 R")
+            .object(2, "<< /Type /Pages /Kids [3 0 R 4 0 R 5 0 R] /Count 3 >>")
+            .object(4, PAGE)
+            .object(5, PAGE)
+            .xref("/Size 11 /Root 1 0 R");
+
+        PreflightResult result = service.scan(pdf.build(), 3);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals(Integer.valueOf(3), result.getPageCount());
+    }
+
+    @Test
+    void fallsBackToLinearizationCountWithoutPageTree() {
+        PdfBuilder pdf = new PdfBuilder("")
+            .object(10, "<< /Linearized 1 /L 1000 /N 4 /T 900 >>")
+            .object(1, CATALOG)
+            .xrefStream(11, "/Root 1 0 R", false);
+
+        PreflightResult result = service.scan(pdf.build(), 4);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertEquals(Integer.valueOf(4), result.getPageCount());
+    }
+
+    @Test
+    void flagsExistingSignaturesFromAcroForm() {
+        PdfBuilder pdf = new PdfBuilder("")
+            .object(1, "<< /Type /Catalog /Pages 2 0 R /AcroForm 4 0 R >>")
+            .object(2, ONE_PAGE)
+            .object(3, PAGE)
+            .object(4, "<< /Fields [] /SigFlags 3 >>")
+            .xref("/Size 5 /Root 1 0 R");
+
+        PreflightResult result = service.scan(pdf.build(), 1);
+
+        assertEquals(PreflightResult.Status.OK, result.getStatus());
+        assertTrue(result.isHasExistingSignatures());
+    }
+
+    private static PdfBuilder onePageDocument() {
+        return new PdfBuilder("")
+            .object(1, CATALOG)
+            .object(2, ONE_PAGE)
+            .object(3, PAGE)
+            .xref("/Size 4 /Root 1 0 R");
+    }
+
+    /**
+     * Writes PDFs with classic xref tables (one section per revision) or a
+     * Flate-compressed xref stream, with offsets relative to the %PDF- header.
+     * Pending entries are {type, field 2, field 3} as in an xref stream.
+     */
+    private static class PdfBuilder {
+        private final StringBuilder out = new StringBuilder();
+        private final Map<Integer, long[]> pending = new LinkedHashMap<>();
+        private final int base;
+        private int lastXref = -1;
+
+        PdfBuilder(String junk) {
+            out.append(junk);
+            base = out.length();
+            out.append("%PDF-1.7\n");
+        }
+
+        PdfBuilder object(int number, String body) {
+            pending.put(number, new long[] {1, out.length() - base, 0});
+            out.append(number).append(" 0 obj\n").append(body).append("\nendobj\n");
+            return this;
+        }
+
+        /** Stores {@code bodies} as objects firstObject, firstObject + 1, ... of an object stream. */
+        PdfBuilder objectStream(int number, int firstObject, String... bodies) {
+            StringBuilder header = new StringBuilder();
+            StringBuilder content = new StringBuilder();
+            for (int i = 0; i < bodies.length; i++) {
+                header.append(firstObject + i).append(' ').append(content.length()).append(' ');
+                content.append(bodies[i]).append('\n');
+                pending.put(firstObject + i, new long[] {2, number, i});
+            }
+            String data = deflate((header.toString() + content).getBytes(StandardCharsets.ISO_8859_1));
+            pending.put(number, new long[] {1, out.length() - base, 0});
+            out.append(number).append(" 0 obj\n<< /Type /ObjStm /N ").append(bodies.length)
+                .append(" /First ").append(header.length())
+                .append(" /Filter /FlateDecode /Length ").append(data.length()).append(" >>\nstream\n")
+                .append(data).append("\nendstream\nendobj\n");
+            return this;
+        }
+
+        PdfBuilder xref(String trailer) {
+            int position = out.length() - base;
+            out.append("xref\n");
+            if (lastXref < 0) {
+                out.append("0 1\n0000000000 65535 f \n");
+            }
+            for (Map.Entry<Integer, long[]> entry : pending.entrySet()) {
+                out.append(entry.getKey()).append(" 1\n")
+                    .append(String.format("%010d 00000 n \n", entry.getValue()[1]));
+            }
+            out.append("trailer\n<< ").append(trailer);
+            if (lastXref >= 0) {
+                out.append(" /Prev ").append(lastXref);
+            }
+            out.append(" >>\nstartxref\n").append(position).append("\n%%EOF\n");
+            lastXref = position;
+            pending.clear();
+            return this;
+        }
+
+        /** Writes an xref stream with /W [1 4 1], optionally PNG Up-predicted. */
+        PdfBuilder xrefStream(int number, String trailer, boolean pngPredictor) {
+            int position = out.length() - base;
+            pending.put(number, new long[] {1, position, 0});
+            int size = Collections.max(pending.keySet()) + 1;
+
+            ByteArrayOutputStream rows = new ByteArrayOutputStream();
+            byte[] previous = new byte[6];
+            for (int object = 0; object < size; object++) {
+                long[] entry = pending.getOrDefault(object, new long[] {0, 0, 0});
+                byte[] row = {(byte) entry[0], (byte) (entry[1] >>> 24), (byte) (entry[1] >>> 16),
+                    (byte) (entry[1] >>> 8), (byte) entry[1], (byte) entry[2]};
+                if (pngPredictor) {
+                    rows.write(2);
+                    for (int i = 0; i < row.length; i++) {
+                        rows.write(row[i] - previous[i]);
+                    }
+                    previous = row;
+                } else {
+                    rows.write(row, 0, row.length);
+                }
+            }
+            String data = deflate(rows.toByteArray());
+
+            out.append(number).append(" 0 obj\n<< /Type /XRef /Size ").append(size).append(" /W [1 4 1] ").append(trailer);
+            if (lastXref >= 0) {
+                out.append(" /Prev ").append(lastXref);
+            }
+            if (pngPredictor) {
+                out.append(" /DecodeParms << /Columns 6 /Predictor 12 >>");
+            }
+            out.append(" /Filter /FlateDecode /Length ").append(data.length()).append(" >>\nstream\n")
+                .append(data).append("\nendstream\nendobj\n")
+                .append("startxref\n").append(position).append("\n%%EOF\n");
+            lastXref = position;
+            pending.clear();
+            return this;
+        }
+
+        PdfBuilder append(String text) {
+            out.append(text);
+            return this;
+        }
+
+        byte[] build() {
+            return out.toString().getBytes(StandardCharsets.ISO_8859_1);
+        }
+
+        private static String deflate(byte[] data) {
+            Deflater deflater = new Deflater();
+            deflater.setInput(data);
+            deflater.finish();
+            ByteArrayOutputStream compressed = new ByteArrayOutputStream();
+            byte[] buffer = new byte[1024];
+            while (!deflater.finished()) {
+                compressed.write(buffer, 0, deflater.deflate(buffer));
+            }
+            deflater.end();
+            return new String(compressed.toByteArray(), StandardCharsets.ISO_8859_1);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+package com.firmador.backend.service;
+
+import org.junit.jupiter.api.Test;
+
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.spec.ECGenParameterSpec;
+import java.util.List;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * Signing and SHA-256 throughput of the OpenSSL-backed provider (when it
+ * loads), the JDK providers and BouncyCastle, the same measurement the
+ * backend runs at startup with firmador.signature.benchmark-enabled. Use it
+ * to decide firmador.signature.providers for a machine type instead of
+ * timing on every boot. Not part of the default test run; run with
+ *
+ *   mvn test -Dtest=SignatureProviderBenchmark
+ *
+ * Per-provider operations per second are logged by SignatureProviderSelector.
+ */
+class SignatureProviderBenchmark {
+
+    private static final List<Integer> RSA_BITS = List.of(2048, 3072, 4096);
+
+    @Test
+    void compareProviders() throws Exception {
+        int threads = Runtime.getRuntime().availableProcessors();
+        SignatureProviderSelector selector = new SignatureProviderSelector(
+            List.of("SunRsaSign", "SunEC", "SUN", "BC"), true, "", true, RSA_BITS, threads, 2_000, 3_000);
+        selector.select();
+
+        KeyPairGenerator rsa = KeyPairGenerator.getInstance("RSA");
+        for (int bits : RSA_BITS) {
+            rsa.initialize(bits);
+            KeyPair keys = rsa.generateKeyPair();
+            String provider = selector.providerFor(keys.getPrivate());
+            System.out.printf("RSA-%d: %s%n", bits, provider);
+            assertNotNull(provider);
+        }
+        KeyPairGenerator ec = KeyPairGenerator.getInstance("EC");
+        ec.initialize(new ECGenParameterSpec("secp256r1"));
+        System.out.printf("EC P-256: %s%n", selector.providerFor(ec.generateKeyPair().getPrivate()));
+    }
+}
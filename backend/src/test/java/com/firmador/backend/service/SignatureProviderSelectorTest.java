@@ -0,0 +1,106 @@
+package com.firmador.backend.service;
+
+import com.amazon.corretto.crypto.provider.AmazonCorrettoCryptoProvider;
+import com.itextpdf.signatures.IExternalSignature;
+import org.junit.jupiter.api.BeforeAll;
+import org.junit.jupiter.api.Test;
+
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.Signature;
+import java.security.spec.ECGenParameterSpec;
+import java.util.List;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.junit.jupiter.api.Assumptions.assumeTrue;
+
+class SignatureProviderSelectorTest {
+
+    private static final List<String> CANDIDATES = List.of("SunRsaSign", "SunEC", "SUN", "BC");
+
+    private static KeyPair rsa1024;
+    private static KeyPair rsa2048;
+    private static KeyPair rsa3072;
+    private static KeyPair ec;
+
+    @BeforeAll
+    static void generateKeys() throws Exception {
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("RSA");
+        generator.initialize(1024);
+        rsa1024 = generator.generateKeyPair();
+        generator.initialize(2048);
+        rsa2048 = generator.generateKeyPair();
+        generator.initialize(3072);
+        rsa3072 = generator.generateKeyPair();
+        KeyPairGenerator ecGenerator = KeyPairGenerator.getInstance("EC");
+        ecGenerator.initialize(new ECGenParameterSpec("secp256r1"));
+        ec = ecGenerator.generateKeyPair();
+    }
+
+    @Test
+    void usesFirstSupportingProviderWhenBenchmarkDisabled() {
+        SignatureProviderSelector selector = selector(false, 2);
+        selector.select();
+
+        assertEquals("SunRsaSign", selector.providerFor(rsa2048.getPrivate()));
+        assertEquals("SunEC", selector.providerFor(ec.getPrivate()));
+    }
+
+    @Test
+    void prefersNativeProviderWhenItLoads() throws Exception {
+        AmazonCorrettoCryptoProvider accp = AmazonCorrettoCryptoProvider.INSTANCE;
+        assumeTrue(accp.getLoadingError() == null, "ACCP native library does not load on this platform");
+        SignatureProviderSelector selector = new SignatureProviderSelector(
+            CANDIDATES, true, "", false, List.of(2048), 1, 0, 0);
+        selector.select();
+
+        assertEquals(accp.getName(), selector.providerFor(rsa2048.getPrivate()));
+        assertEquals(accp.getName(), selector.providerFor(ec.getPrivate()));
+        byte[] message = "firmador".getBytes();
+        Signature verifier = Signature.getInstance("SHA256withRSA");
+        verifier.initVerify(rsa2048.getPublic());
+        verifier.update(message);
+        assertTrue(verifier.verify(selector.createSignature(rsa2048.getPrivate()).sign(message)));
+    }
+
+    @Test
+    void selectsSupportingProviderPerKeySizeUnderConcurrency() {
+        SignatureProviderSelector selector = selector(true, 3);
+        selector.select();
+
+        assertTrue(List.of("SunRsaSign", "BC").contains(selector.providerFor(rsa1024.getPrivate())));
+        assertTrue(List.of("SunRsaSign", "BC").contains(selector.providerFor(rsa2048.getPrivate())));
+        assertTrue(List.of("SunEC", "BC").contains(selector.providerFor(ec.getPrivate())));
+    }
+
+    @Test
+    void mapsUnmeasuredRsaSizeToNearestMeasuredSize() {
+        SignatureProviderSelector selector = selector(true, 1);
+        selector.select();
+
+        // 3072 is closer to 2048 than to 1024
+        assertEquals(selector.providerFor(rsa2048.getPrivate()), selector.providerFor(rsa3072.getPrivate()));
+    }
+
+    @Test
+    void createsVerifiableSignatures() throws Exception {
+        SignatureProviderSelector selector = selector(true, 2);
+        selector.select();
+        byte[] message = "firmador".getBytes();
+
+        for (KeyPair keys : List.of(rsa2048, ec)) {
+            IExternalSignature signature = selector.createSignature(keys.getPrivate());
+            byte[] signed = signature.sign(message);
+
+            Signature verifier = Signature.getInstance(
+                "SHA256with" + ("EC".equals(keys.getPublic().getAlgorithm()) ? "ECDSA" : "RSA"));
+            verifier.initVerify(keys.getPublic());
+            verifier.update(message);
+            assertTrue(verifier.verify(signed), keys.getPublic().getAlgorithm());
+        }
+    }
+
+    private static SignatureProviderSelector selector(boolean benchmark, int threads) {
+        return new SignatureProviderSelector(CANDIDATES, false, "", benchmark, List.of(1024, 2048), threads, 50, 50);
+    }
+}
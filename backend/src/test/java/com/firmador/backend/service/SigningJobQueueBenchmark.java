@@ -0,0 +1,106 @@
+package com.firmador.backend.service;
+
+import com.fasterxml.jackson.databind.ObjectMapper;
+import com.firmador.backend.dto.SignatureRequest;
+import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.nio.file.Path;
+import java.util.ArrayList;
+import java.util.Base64;
+import java.util.List;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * Throughput of the shared-directory queue as instances are added. Each
+ * instance is a {@link SigningJobQueue} with its own id and worker threads
+ * over one directory, and signing is simulated with a fixed sleep, so the
+ * numbers show the coordination overhead (listing, claim races, renames)
+ * rather than CPU-bound signing. Not part of the default test run; run with
+ *
+ *   mvn test -Dtest=SigningJobQueueBenchmark
+ *
+ * Point -Dfirmador.benchmark.queue-path at an NFS mount to measure the share
+ * the cluster will actually use.
+ */
+class SigningJobQueueBenchmark {
+
+    private static final int JOBS = 400;
+    private static final int WORKERS_PER_INSTANCE = 4;
+    private static final long SIGN_MILLIS = 20;
+    private static final String SECRET_KEY = Base64.getEncoder().encodeToString(new byte[32]);
+
+    private final ObjectMapper objectMapper = new ObjectMapper().findAndRegisterModules();
+
+    @TempDir
+    Path tempDir;
+
+    @Test
+    void measureThroughputAcrossInstanceCounts() throws Exception {
+        Path base = Path.of(System.getProperty("firmador.benchmark.queue-path", tempDir.toString()));
+        System.out.printf("%d jobs, %d workers per instance, %d ms per job%n", JOBS, WORKERS_PER_INSTANCE, SIGN_MILLIS);
+        System.out.printf("%-10s %10s %10s %14s%n", "instances", "millis", "jobs/s", "empty polls");
+
+        double previous = 0;
+        for (int instances : new int[] {1, 2, 4}) {
+            Path queuePath = base.resolve("queue-" + instances + "-" + System.nanoTime());
+            List<SigningJobQueue> queues = new ArrayList<>();
+            for (int i = 1; i <= instances; i++) {
+                queues.add(new SigningJobQueue(objectMapper, true, queuePath.toString(), 60, 60,
+                    "instance-" + i, SECRET_KEY));
+            }
+            for (int job = 0; job < JOBS; job++) {
+                queues.get(0).submit(new byte[1024], "documento-" + job + ".pdf", request());
+            }
+
+            AtomicInteger completed = new AtomicInteger();
+            AtomicInteger emptyClaims = new AtomicInteger();
+            ExecutorService workers = Executors.newFixedThreadPool(instances * WORKERS_PER_INSTANCE);
+            long start = System.nanoTime();
+            for (SigningJobQueue queue : queues) {
+                for (int w = 0; w < WORKERS_PER_INSTANCE; w++) {
+                    workers.submit(() -> {
+                        while (completed.get() < JOBS) {
+                            var job = queue.claim();
+                            if (job.isEmpty()) {
+                                emptyClaims.incrementAndGet();
+                                Thread.sleep(5);
+                                continue;
+                            }
+                            Thread.sleep(SIGN_MILLIS);
+                            if (queue.complete(job.get().getJobId(), new byte[1024], "signed.pdf")) {
+                                completed.incrementAndGet();
+                            }
+                        }
+                        return null;
+                    });
+                }
+            }
+            workers.shutdown();
+            assertTrue(workers.awaitTermination(5, TimeUnit.MINUTES), "queue did not drain");
+            long millis = (System.nanoTime() - start) / 1_000_000;
+
+            double throughput = JOBS * 1000.0 / millis;
+            System.out.printf("%-10d %10d %10.1f %14d%n", instances, millis, throughput, emptyClaims.get());
+            assertEquals(JOBS, completed.get());
+            if (previous > 0) {
+                assertTrue(throughput > previous, "adding instances should add throughput");
+            }
+            previous = throughput;
+        }
+    }
+
+    private static SignatureRequest request() {
+        SignatureRequest request = new SignatureRequest();
+        request.setSignerName("Benchmark");
+        request.setSignerId("0000000000");
+        request.setCertificateData(new byte[2048]);
+        request.setCertificatePassword("benchmark");
+        return request;
+    }
+}
@@ -0,0 +1,76 @@
+package com.firmador.backend.service;
+
+import com.fasterxml.jackson.databind.ObjectMapper;
+import com.firmador.backend.dto.SignatureRequest;
+import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.Base64;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+class SigningJobQueueTest {
+
+    private static final String SECRET_KEY = Base64.getEncoder().encodeToString(new byte[32]);
+
+    private final ObjectMapper objectMapper = new ObjectMapper().findAndRegisterModules();
+
+    @TempDir
+    Path queuePath;
+
+    @Test
+    void completesClaimedJob() throws Exception {
+        SigningJobQueue queue = queue("instance-a", 60);
+        String jobId = queue.submit("%PDF-1.7".getBytes(), "contrato.pdf", request());
+
+        SigningJobQueue.ClaimedJob job = queue.claim().orElseThrow();
+        assertEquals(jobId, job.getJobId());
+        assertTrue(queue.heartbeat(jobId));
+        assertTrue(queue.complete(jobId, "signed".getBytes(), "contrato_signed.pdf"));
+
+        assertEquals(SigningJobQueue.JobState.DONE, queue.status(jobId).orElseThrow().getState());
+        assertArrayEquals("signed".getBytes(), Files.readAllBytes(queue.resultPath(jobId).orElseThrow()));
+        assertFalse(Files.exists(queuePath.resolve("claimed").resolve(jobId)));
+    }
+
+    @Test
+    void pausedInstanceDoesNotFinishJobReclaimedByAnother() throws Exception {
+        // A zero lease lets the first instance's own reaper expire its claim
+        SigningJobQueue paused = queue("instance-a", 0);
+        SigningJobQueue other = queue("instance-b", 60);
+        String jobId = paused.submit("%PDF-1.7".getBytes(), "contrato.pdf", request());
+
+        paused.claim().orElseThrow();
+        Thread.sleep(10);
+        assertEquals(1, paused.reapExpiredLeases());
+        other.claim().orElseThrow();
+
+        assertFalse(paused.heartbeat(jobId));
+        assertFalse(paused.complete(jobId, "stale".getBytes(), "contrato_signed.pdf"));
+        assertFalse(paused.fail(jobId, "stale"));
+
+        // The new owner's claim, lease and result are untouched
+        assertTrue(other.heartbeat(jobId));
+        assertEquals(SigningJobQueue.JobState.RUNNING, other.status(jobId).orElseThrow().getState());
+        assertTrue(other.complete(jobId, "signed".getBytes(), "contrato_signed.pdf"));
+        SigningJobQueue.JobStatus status = other.status(jobId).orElseThrow();
+        assertEquals(SigningJobQueue.JobState.DONE, status.getState());
+        assertEquals("instance-b", status.getInstanceId());
+        assertArrayEquals("signed".getBytes(), Files.readAllBytes(other.resultPath(jobId).orElseThrow()));
+    }
+
+    private SigningJobQueue queue(String instanceId, long leaseSeconds) throws Exception {
+        return new SigningJobQueue(objectMapper, true, queuePath.toString(), leaseSeconds, 60, instanceId, SECRET_KEY);
+    }
+
+    private static SignatureRequest request() {
+        SignatureRequest request = new SignatureRequest();
+        request.setSignerName("Ana Pérez");
+        request.setSignerId("0102030405");
+        request.setCertificateData(new byte[] {1, 2, 3});
+        request.setCertificatePassword("secret");
+        return request;
+    }
+}
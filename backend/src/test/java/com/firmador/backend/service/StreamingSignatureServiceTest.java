@@ -0,0 +1,182 @@
+package com.firmador.backend.service;
+
+import com.fasterxml.jackson.databind.ObjectMapper;
+import com.firmador.backend.dto.PreflightResult;
+import com.firmador.backend.dto.SignatureRequest;
+import org.junit.jupiter.api.Test;
+import org.junit.jupiter.api.io.TempDir;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.security.MessageDigest;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Map;
+import java.util.stream.Stream;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.jupiter.api.Assertions.*;
+import static org.mockito.ArgumentMatchers.*;
+import static org.mockito.Mockito.*;
+
+class StreamingSignatureServiceTest {
+
+    private static final byte[] PDF = "%PDF-1.7\n%%EOF\n".getBytes(StandardCharsets.ISO_8859_1);
+    private static final byte[] SIGNED = "%PDF-1.7\n%signed\n%%EOF\n".getBytes(StandardCharsets.ISO_8859_1);
+
+    private final ObjectMapper objectMapper = new ObjectMapper();
+
+    @TempDir
+    Path storagePath;
+
+    @Test
+    void boundsConcurrentKeyLoadsToPoolSize() throws Exception {
+        DigitalSignatureService signatures = mock(DigitalSignatureService.class);
+        AtomicInteger loading = new AtomicInteger();
+        AtomicInteger peak = new AtomicInteger();
+        when(signatures.loadSigningKey(any(), anyString())).thenAnswer(invocation -> {
+            peak.accumulateAndGet(loading.incrementAndGet(), Math::max);
+            Thread.sleep(50);
+            loading.decrementAndGet();
+            return new DigitalSignatureService.SigningKey("alias", null, null);
+        });
+        when(signatures.signPdf(any(byte[].class), any(SignatureRequest.class), any())).thenReturn(PDF);
+        StreamingSignatureService service = new StreamingSignatureService(
+            signatures, preflightOk(), storage(), objectMapper, 50, 2);
+
+        ExecutorService clients = Executors.newFixedThreadPool(8);
+        try {
+            List<Future<byte[]>> responses = new ArrayList<>();
+            for (int i = 0; i < 8; i++) {
+                responses.add(clients.submit(() -> {
+                    ByteArrayOutputStream out = new ByteArrayOutputStream();
+                    service.sign(new ByteArrayInputStream(request(PDF)), out);
+                    return out.toByteArray();
+                }));
+            }
+            for (Future<byte[]> response : responses) {
+                assertEquals(StreamingSignatureService.FRAME_RESULT, response.get()[0]);
+            }
+        } finally {
+            clients.shutdownNow();
+            service.shutdown();
+        }
+
+        verify(signatures, times(8)).loadSigningKey(any(), anyString());
+        assertTrue(peak.get() <= 2, "peak concurrent key loads: " + peak.get());
+    }
+
+    @Test
+    void rejectsNonPdfDocumentAsItArrives() throws Exception {
+        StreamingSignatureService service = new StreamingSignatureService(
+            mock(DigitalSignatureService.class), preflightOk(), storage(), objectMapper, 50, 1);
+        try {
+            StreamingSignatureService.StreamSignException error = assertThrows(
+                StreamingSignatureService.StreamSignException.class,
+                () -> service.sign(new ByteArrayInputStream(request("not a pdf".getBytes())), new ByteArrayOutputStream()));
+            assertEquals(422, error.getStatus());
+            assertEquals("NOT_PDF", error.getCode());
+        } finally {
+            service.shutdown();
+        }
+    }
+
+    @Test
+    void signsLargeDocumentFromStagingFile() throws Exception {
+        DigitalSignatureService signatures = mock(DigitalSignatureService.class);
+        when(signatures.loadSigningKey(any(), anyString()))
+            .thenReturn(new DigitalSignatureService.SigningKey("alias", null, null));
+        when(signatures.isLargeDocument(anyLong())).thenReturn(true);
+        doAnswer(invocation -> {
+            Path input = invocation.getArgument(0);
+            assertArrayEquals(PDF, Files.readAllBytes(input));
+            Files.write(invocation.getArgument(1), SIGNED);
+            return null;
+        }).when(signatures).signPdf(any(Path.class), any(Path.class), any(SignatureRequest.class), any());
+        StreamingSignatureService service = new StreamingSignatureService(
+            signatures, preflightOk(), storage(), objectMapper, 50, 1);
+        try {
+            ByteArrayOutputStream out = new ByteArrayOutputStream();
+            service.sign(new ByteArrayInputStream(request(PDF, sha256(PDF))), out);
+
+            byte[] response = out.toByteArray();
+            assertEquals(StreamingSignatureService.FRAME_RESULT, response[0]);
+            assertArrayEquals(SIGNED, Arrays.copyOfRange(response, 5, 5 + SIGNED.length));
+        } finally {
+            service.shutdown();
+        }
+
+        verify(signatures, never()).signPdf(any(byte[].class), any(SignatureRequest.class), any());
+        try (Stream<Path> staged = Files.list(storagePath.resolve("documents"))) {
+            assertEquals(0, staged.count(), "staging files must be deleted");
+        }
+    }
+
+    @Test
+    void rejectsDocumentWhoseHashDoesNotMatch() throws Exception {
+        DigitalSignatureService signatures = mock(DigitalSignatureService.class);
+        StreamingSignatureService service = new StreamingSignatureService(
+            signatures, preflightOk(), storage(), objectMapper, 50, 1);
+        try {
+            StreamingSignatureService.StreamSignException error = assertThrows(
+                StreamingSignatureService.StreamSignException.class,
+                () -> service.sign(new ByteArrayInputStream(request(PDF, sha256("other".getBytes()))),
+                    new ByteArrayOutputStream()));
+            assertEquals(400, error.getStatus());
+            assertEquals("DOCUMENT_HASH_MISMATCH", error.getCode());
+        } finally {
+            service.shutdown();
+        }
+
+        verify(signatures, never()).signPdf(any(byte[].class), any(SignatureRequest.class), any());
+        verify(signatures, never()).signPdf(any(Path.class), any(Path.class), any(SignatureRequest.class), any());
+    }
+
+    private static PdfPreflightService preflightOk() throws IOException {
+        PdfPreflightService preflight = mock(PdfPreflightService.class);
+        when(preflight.scan(any(Path.class), anyInt())).thenReturn(new PreflightResult(PreflightResult.Status.OK, "OK"));
+        return preflight;
+    }
+
+    private DocumentStorageService storage() throws IOException {
+        return new DocumentStorageService(storagePath.toString(), 60, false, "/protected-storage/");
+    }
+
+    private static byte[] sha256(byte[] data) throws Exception {
+        return MessageDigest.getInstance("SHA-256").digest(data);
+    }
+
+    private byte[] request(byte[] document) throws IOException {
+        return request(document, new byte[0]);
+    }
+
+    private byte[] request(byte[] document, byte[] sha256) throws IOException {
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        DataOutputStream out = new DataOutputStream(bytes);
+        frame(out, StreamingSignatureService.FRAME_METADATA, objectMapper.writeValueAsBytes(Map.of(
+            "signerName", "Ana Pérez",
+            "signerId", "0102030405",
+            "location", "Quito",
+            "reason", "Prueba",
+            "certificatePassword", "secret")));
+        frame(out, StreamingSignatureService.FRAME_CERTIFICATE, new byte[] {1, 2, 3});
+        frame(out, StreamingSignatureService.FRAME_DOCUMENT, document);
+        frame(out, StreamingSignatureService.FRAME_END, sha256);
+        return bytes.toByteArray();
+    }
+
+    private static void frame(DataOutputStream out, int type, byte[] payload) throws IOException {
+        out.writeByte(type);
+        out.writeInt(payload.length);
+        out.write(payload);
+    }
+}
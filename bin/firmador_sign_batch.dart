@@ -0,0 +1,14 @@
+// Standalone batch signer for servers without a display.
+//
+//   flutter pub get
+//   dart compile exe bin/firmador_sign_batch.dart -o build/firmador-sign-batch
+//
+// Only dart:io and dio are reachable from here; importing anything that
+// pulls in Flutter (dart:ui) makes `dart compile exe` fail.
+import 'dart:io';
+
+import 'package:firmador/src/presentation/cli/sign_batch_command.dart';
+
+Future<void> main(List<String> args) async {
+  exit(await SignBatchCommand.run(args));
+}
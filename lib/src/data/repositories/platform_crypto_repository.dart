@@ -1,11 +1,17 @@
 import 'dart:io';
 
+import 'package:firmador/src/data/services/certificate_keyring_cache.dart';
 import 'package:firmador/src/domain/entities/certificate_info.dart';
 import 'package:firmador/src/domain/repositories/crypto_repository.dart';
+import 'package:firmador_native/firmador_native.dart' as native;
 import 'package:flutter/services.dart';
 
 /// An implementation of [CryptoRepository] that uses a [MethodChannel]
 /// to call native platform code for cryptographic operations.
+///
+/// On Linux the native engine is loaded through `dart:ffi` instead, so
+/// paths go straight to native code and results come back from a helper
+/// isolate without serializing through the platform thread.
 class PlatformCryptoRepository implements CryptoRepository {
   static const _channel = MethodChannel('com.firmador/crypto');
 
@@ -14,6 +20,9 @@ class PlatformCryptoRepository implements CryptoRepository {
     required String p12Path,
     required String password,
   }) async {
+    if (Platform.isLinux) {
+      return _getCertificateInfoFfi(p12Path: p12Path, password: password);
+    }
     try {
       final result = await _channel.invokeMapMethod<String, dynamic>(
         'getCertificateInfo',
@@ -29,6 +38,32 @@ class PlatformCryptoRepository implements CryptoRepository {
     }
   }
 
+  Future<CertificateInfo> _getCertificateInfoFfi({
+    required String p12Path,
+    required String password,
+  }) async {
+    final p12File = File(p12Path);
+    final cached = await CertificateKeyringCache.lookup(p12File, password);
+    if (cached != null) {
+      return cached;
+    }
+    try {
+      final info = await native.certificateInfo(p12Path, password);
+      final certificateInfo = CertificateInfo(
+        subject: info.subject,
+        issuer: info.issuer,
+        validFrom: info.validFrom.toLocal(),
+        validTo: info.validTo.toLocal(),
+        serialNumber: info.serialNumber,
+        commonName: info.commonName,
+      );
+      await CertificateKeyringCache.store(p12File, password, certificateInfo);
+      return certificateInfo;
+    } on native.FirmadorNativeException catch (e) {
+      throw Exception(e.message);
+    }
+  }
+
   @override
   Future<File> signPdf({
     required String pdfPath,
@@ -1,8 +1,11 @@
 import 'dart:io';
 import 'package:dio/dio.dart';
 import 'package:firmador/src/domain/entities/certificate_info.dart';
+import 'package:firmador/src/data/services/sign_stream_client.dart';
 import 'package:path_provider/path_provider.dart';
 
+export 'package:firmador/src/data/services/sign_stream_client.dart' show SignatureResult;
+
 class BackendSignatureService {
   static const String _baseUrl = 'http://localhost:8080'; // Change for production
   late final Dio _dio;
@@ -166,6 +169,57 @@ class BackendSignatureService {
     }
   }
 
+  /// Sign a document over the framed binary protocol of /api/signature/sign-stream.
+  ///
+  /// See [SignStreamClient]; the signed PDF goes to Documents/Signed_PDFs.
+  Future<SignatureResult> signDocumentStream({
+    required File documentFile,
+    required File certificateFile,
+    required String signerName,
+    required String signerId,
+    required String location,
+    required String reason,
+    required String certificatePassword,
+    double signatureX = 100.0,
+    double signatureY = 100.0,
+    double signatureWidth = 150.0,
+    double signatureHeight = 50.0,
+    int signaturePage = 1,
+    bool enableTimestamp = false,
+    String timestampServerUrl = 'https://freetsa.org/tsr',
+  }) async {
+    return SignStreamClient(_dio).sign(
+      documentFile: documentFile,
+      certificateFile: certificateFile,
+      signerName: signerName,
+      signerId: signerId,
+      location: location,
+      reason: reason,
+      certificatePassword: certificatePassword,
+      signatureX: signatureX,
+      signatureY: signatureY,
+      signatureWidth: signatureWidth,
+      signatureHeight: signatureHeight,
+      signaturePage: signaturePage,
+      enableTimestamp: enableTimestamp,
+      timestampServerUrl: timestampServerUrl,
+      outputDirectory: await _signedPdfsDirectory(),
+    );
+  }
+
+  Future<Directory> _signedPdfsDirectory() async {
+    try {
+      final documentsDir = await getApplicationDocumentsDirectory();
+      final signedPdfsDir = Directory('${documentsDir.path}/Signed_PDFs');
+      if (!await signedPdfsDir.exists()) {
+        await signedPdfsDir.create(recursive: true);
+      }
+      return signedPdfsDir;
+    } catch (e) {
+      return Directory.systemTemp;
+    }
+  }
+
   /// Validate a certificate using the backend service
   Future<CertificateValidationResult> validateCertificate({
     required File certificateFile,
@@ -292,47 +346,10 @@ class BackendSignatureService {
     }
   }
 
-  String _handleDioError(DioException e) {
-    switch (e.type) {
-      case DioExceptionType.connectionTimeout:
-      case DioExceptionType.sendTimeout:
-      case DioExceptionType.receiveTimeout:
-        return 'Tiempo de conexión agotado. Verifica tu conexión a internet.';
-      case DioExceptionType.badResponse:
-        final statusCode = e.response?.statusCode;
-        final message = e.response?.data?['message'] ?? e.message;
-        return 'Error del servidor ($statusCode): $message';
-      case DioExceptionType.connectionError:
-        return 'Error de conexión. Verifica que el servidor esté funcionando.';
-      case DioExceptionType.cancel:
-        return 'Operación cancelada';
-      default:
-        return 'Error de red: ${e.message}';
-    }
-  }
+  String _handleDioError(DioException e) => describeDioError(e);
 }
 
 // Result classes for better type safety
-class SignatureResult {
-  final bool success;
-  final String message;
-  final String? documentId;
-  final String? filename;
-  final String? downloadUrl;
-  final DateTime? signedAt;
-  final int? fileSize;
-
-  SignatureResult({
-    required this.success,
-    required this.message,
-    this.documentId,
-    this.filename,
-    this.downloadUrl,
-    this.signedAt,
-    this.fileSize,
-  });
-}
-
 class CertificateValidationResult {
   final bool valid;
   final String message;
@@ -0,0 +1,150 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:crypto/crypto.dart';
+import 'package:firmador/src/domain/entities/certificate_info.dart';
+import 'package:firmador_native/firmador_native.dart' as native;
+import 'package:flutter/foundation.dart';
+import 'package:flutter_secure_storage/flutter_secure_storage.dart';
+
+/// Caches the metadata of certificates that were unlocked successfully in the
+/// system keyring (libsecret through flutter_secure_storage on Linux), so that
+/// re-entering the password of a known .p12 does not run the PKCS#12 PBKDF
+/// again, neither natively nor on the backend.
+///
+/// Entries are keyed by the SHA-256 of the .p12 file and hold an
+/// HMAC-SHA256 of the password under a random key generated for that entry
+/// and stored next to it, so a wrong password never matches and the password
+/// itself is never written. They survive restarts and expire after
+/// [reauthInterval]; the next lookup then falls through to a full unlock.
+/// No key material is cached: signing happens on the backend, which receives
+/// the .p12 and its password with each request.
+class CertificateKeyringCache {
+  static const String _keyPrefix = 'certificate_cache_';
+  static const Duration reauthInterval = Duration(minutes: 15);
+
+  static const FlutterSecureStorage _storage = FlutterSecureStorage();
+
+  static bool get isSupported => Platform.isLinux;
+
+  /// Returns the cached metadata for [certificateFile] unlocked with
+  /// [password], or null when there is no fresh entry for that pair.
+  static Future<CertificateInfo?> lookup(
+      File certificateFile, String password) async {
+    if (!isSupported) {
+      return null;
+    }
+    try {
+      final fingerprint = await _fingerprint(certificateFile);
+      final raw = await _storage.read(key: '$_keyPrefix$fingerprint');
+      if (raw == null) {
+        return null;
+      }
+
+      final entry = jsonDecode(raw) as Map<String, dynamic>;
+      final info = CertificateInfo.fromMap(entry['info'] as Map);
+      if (_isExpired(entry, info)) {
+        await _storage.delete(key: '$_keyPrefix$fingerprint');
+        return null;
+      }
+
+      final key = base64Decode(entry['key'] as String);
+      if (!_constantTimeEquals(
+          _passwordVerifier(key, password), base64Decode(entry['verifier'] as String))) {
+        return null;
+      }
+      return info;
+    } catch (e) {
+      debugPrint('Certificate keyring lookup failed: $e');
+      return null;
+    }
+  }
+
+  /// Records a successful full unlock of [certificateFile] with [password].
+  static Future<void> store(
+      File certificateFile, String password, CertificateInfo info) async {
+    if (!isSupported) {
+      return;
+    }
+    try {
+      await _purgeExpired();
+      final fingerprint = await _fingerprint(certificateFile);
+      final key = _randomBytes(32);
+      await _storage.write(
+        key: '$_keyPrefix$fingerprint',
+        value: jsonEncode({
+          'cachedAt': DateTime.now().millisecondsSinceEpoch,
+          'key': base64Encode(key),
+          'verifier': base64Encode(_passwordVerifier(key, password)),
+          'info': {
+            'subject': info.subject,
+            'issuer': info.issuer,
+            'validFrom': info.validFrom.millisecondsSinceEpoch,
+            'validTo': info.validTo.millisecondsSinceEpoch,
+            'serialNumber': info.serialNumber,
+            'commonName': info.commonName,
+            'keyUsages': info.keyUsages,
+            'isTrusted': info.isTrusted,
+          },
+        }),
+      );
+    } catch (e) {
+      debugPrint('Certificate keyring store failed: $e');
+    }
+  }
+
+  /// Drops entries of other certificates that were never looked up again.
+  static Future<void> _purgeExpired() async {
+    final entries = await _storage.readAll();
+    for (final MapEntry(:key, :value) in entries.entries) {
+      if (!key.startsWith(_keyPrefix)) {
+        continue;
+      }
+      try {
+        final entry = jsonDecode(value) as Map<String, dynamic>;
+        if (!_isExpired(entry, CertificateInfo.fromMap(entry['info'] as Map))) {
+          continue;
+        }
+      } catch (_) {
+        // Unreadable entries, e.g. from an older format, are dropped too
+      }
+      await _storage.delete(key: key);
+    }
+  }
+
+  static bool _isExpired(Map<String, dynamic> entry, CertificateInfo info) {
+    final cachedAt =
+        DateTime.fromMillisecondsSinceEpoch(entry['cachedAt'] as int);
+    final now = DateTime.now();
+    return now.difference(cachedAt) > reauthInterval ||
+        now.isAfter(info.validTo);
+  }
+
+  static Future<String> _fingerprint(File certificateFile) async {
+    final digest = await native.sha256File(certificateFile.path);
+    return digest.map((b) => b.toRadixString(16).padLeft(2, '0')).join();
+  }
+
+  static List<int> _passwordVerifier(List<int> key, String password) {
+    return Hmac(sha256, key).convert(utf8.encode(password)).bytes;
+  }
+
+  static Uint8List _randomBytes(int length) {
+    final random = Random.secure();
+    return Uint8List.fromList(
+        List<int>.generate(length, (_) => random.nextInt(256)));
+  }
+
+  static bool _constantTimeEquals(List<int> a, List<int> b) {
+    if (a.length != b.length) {
+      return false;
+    }
+    var diff = 0;
+    for (var i = 0; i < a.length; i++) {
+      diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+  }
+}
@@ -0,0 +1,261 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:crypto/crypto.dart';
+import 'package:dio/dio.dart';
+
+/// Client for the framed binary protocol of /api/signature/sign-stream.
+///
+/// The document is sent in chunks straight from disk, so the backend starts
+/// hashing it and unlocking the certificate before the upload completes, and
+/// the signed PDF is written to disk as its frames arrive. The chunks are
+/// hashed as they are read and the SHA-256 goes in the END frame, so the
+/// backend rejects a document that changed in transit before signing it.
+///
+/// Depends on dart:io, dio and crypto only, without Flutter, so the batch CLI
+/// in bin/ can be built with `dart compile exe`.
+class SignStreamClient {
+  static const String _streamContentType = 'application/vnd.firmador.sign-stream';
+
+  // Frame types of the /api/signature/sign-stream protocol
+  static const int _frameEnd = 0;
+  static const int _frameMetadata = 1;
+  static const int _frameCertificate = 2;
+  static const int _frameDocument = 3;
+  static const int _frameResult = 4;
+  static const int _frameSummary = 5;
+  static const int _frameError = 6;
+
+  final Dio _dio;
+
+  SignStreamClient(this._dio);
+
+  /// Client with its own connection to [baseUrl] and the timeouts of
+  /// BackendSignatureService, without request logging.
+  factory SignStreamClient.connect(String baseUrl) => SignStreamClient(Dio(BaseOptions(
+        baseUrl: baseUrl,
+        connectTimeout: const Duration(seconds: 30),
+        receiveTimeout: const Duration(minutes: 5),
+        sendTimeout: const Duration(minutes: 2),
+      )));
+
+  /// Check backend health
+  Future<bool> checkHealth() async {
+    try {
+      final response = await _dio.get('/api/signature/health');
+      return response.statusCode == 200;
+    } catch (e) {
+      return false;
+    }
+  }
+
+  /// Signs [documentFile] and writes the signed PDF into [outputDirectory].
+  Future<SignatureResult> sign({
+    required File documentFile,
+    required File certificateFile,
+    required String signerName,
+    required String signerId,
+    required String location,
+    required String reason,
+    required String certificatePassword,
+    double signatureX = 100.0,
+    double signatureY = 100.0,
+    double signatureWidth = 150.0,
+    double signatureHeight = 50.0,
+    int signaturePage = 1,
+    bool enableTimestamp = false,
+    String timestampServerUrl = 'https://freetsa.org/tsr',
+    required Directory outputDirectory,
+  }) async {
+    File? partialFile;
+    try {
+      final metadata = utf8.encode(jsonEncode({
+        'filename': documentFile.path.split('/').last,
+        'documentSize': await documentFile.length(),
+        'signerName': signerName,
+        'signerId': signerId,
+        'location': location,
+        'reason': reason,
+        'certificatePassword': certificatePassword,
+        'signatureX': signatureX,
+        'signatureY': signatureY,
+        'signatureWidth': signatureWidth,
+        'signatureHeight': signatureHeight,
+        'signaturePage': signaturePage,
+        'enableTimestamp': enableTimestamp,
+        'timestampServerUrl': timestampServerUrl,
+      }));
+      final certificateBytes = await certificateFile.readAsBytes();
+
+      Stream<List<int>> requestFrames() async* {
+        yield _frame(_frameMetadata, metadata);
+        yield _frame(_frameCertificate, certificateBytes);
+        final digest = _DigestSink();
+        final hasher = sha256.startChunkedConversion(digest);
+        await for (final chunk in documentFile.openRead()) {
+          hasher.add(chunk);
+          yield _frame(_frameDocument, chunk);
+        }
+        hasher.close();
+        yield _frame(_frameEnd, digest.value.bytes);
+      }
+
+      final response = await _dio.post<ResponseBody>(
+        '/api/signature/sign-stream',
+        data: requestFrames(),
+        options: Options(
+          contentType: _streamContentType,
+          responseType: ResponseType.stream,
+          validateStatus: (_) => true,
+        ),
+      );
+
+      final signedPdfsDir = outputDirectory;
+      partialFile = File(
+          '${signedPdfsDir.path}/.signing_${DateTime.now().microsecondsSinceEpoch}.part');
+      final sink = partialFile.openWrite();
+      Map<String, dynamic>? summary;
+      Map<String, dynamic>? error;
+
+      try {
+        final pending = BytesBuilder(copy: false);
+        await for (final data in response.data!.stream) {
+          pending.add(data);
+          final bytes = pending.takeBytes();
+          var offset = 0;
+          while (bytes.length - offset >= 5) {
+            final length =
+                ByteData.sublistView(bytes, offset + 1, offset + 5).getUint32(0);
+            if (bytes.length - offset - 5 < length) {
+              break;
+            }
+            final type = bytes[offset];
+            final payload =
+                Uint8List.sublistView(bytes, offset + 5, offset + 5 + length);
+            if (type == _frameResult) {
+              sink.add(payload);
+            } else if (type == _frameSummary) {
+              summary = jsonDecode(utf8.decode(payload)) as Map<String, dynamic>;
+            } else if (type == _frameError) {
+              error = jsonDecode(utf8.decode(payload)) as Map<String, dynamic>;
+            }
+            offset += 5 + length;
+          }
+          pending.add(Uint8List.sublistView(bytes, offset));
+        }
+      } finally {
+        await sink.close();
+      }
+
+      if (error != null || summary == null) {
+        await partialFile.delete();
+        return SignatureResult(
+          success: false,
+          message: error != null
+              ? 'Error del servidor (${response.statusCode}): ${error['error']}'
+              : 'Respuesta incompleta del servidor',
+        );
+      }
+
+      final signedFile =
+          await _uniqueFile(signedPdfsDir, summary['filename'] as String);
+      await partialFile.rename(signedFile.path);
+
+      return SignatureResult(
+        success: true,
+        message: 'Documento firmado exitosamente',
+        documentId: null,
+        filename: signedFile.path.split('/').last,
+        downloadUrl: signedFile.path,
+        signedAt: DateTime.now(),
+        fileSize: summary['signedSize'] as int?,
+      );
+    } on DioException catch (e) {
+      return SignatureResult(
+        success: false,
+        message: describeDioError(e),
+      );
+    } catch (e) {
+      if (partialFile != null && await partialFile.exists()) {
+        await partialFile.delete();
+      }
+      return SignatureResult(
+        success: false,
+        message: 'Error inesperado: $e',
+      );
+    }
+  }
+
+  List<int> _frame(int type, List<int> payload) {
+    final frame = Uint8List(5 + payload.length);
+    frame[0] = type;
+    ByteData.sublistView(frame, 1, 5).setUint32(0, payload.length);
+    frame.setRange(5, frame.length, payload);
+    return frame;
+  }
+
+  Future<File> _uniqueFile(Directory directory, String filename) async {
+    final baseFile = File('${directory.path}/$filename');
+    if (!await baseFile.exists()) {
+      return baseFile;
+    }
+    final timestamp = DateTime.now().millisecondsSinceEpoch;
+    final dot = filename.lastIndexOf('.');
+    final nameWithoutExt = dot > 0 ? filename.substring(0, dot) : filename;
+    final extension = dot > 0 ? filename.substring(dot) : '';
+    return File('${directory.path}/${nameWithoutExt}_$timestamp$extension');
+  }
+}
+
+class _DigestSink implements Sink<Digest> {
+  late Digest value;
+
+  @override
+  void add(Digest data) {
+    value = data;
+  }
+
+  @override
+  void close() {}
+}
+
+/// User-facing (Spanish) description of a failed request.
+String describeDioError(DioException e) {
+  switch (e.type) {
+    case DioExceptionType.connectionTimeout:
+    case DioExceptionType.sendTimeout:
+    case DioExceptionType.receiveTimeout:
+      return 'Tiempo de conexión agotado. Verifica tu conexión a internet.';
+    case DioExceptionType.badResponse:
+      final statusCode = e.response?.statusCode;
+      final message = e.response?.data?['message'] ?? e.message;
+      return 'Error del servidor ($statusCode): $message';
+    case DioExceptionType.connectionError:
+      return 'Error de conexión. Verifica que el servidor esté funcionando.';
+    case DioExceptionType.cancel:
+      return 'Operación cancelada';
+    default:
+      return 'Error de red: ${e.message}';
+  }
+}
+
+class SignatureResult {
+  final bool success;
+  final String message;
+  final String? documentId;
+  final String? filename;
+  final String? downloadUrl;
+  final DateTime? signedAt;
+  final int? fileSize;
+
+  SignatureResult({
+    required this.success,
+    required this.message,
+    this.documentId,
+    this.filename,
+    this.downloadUrl,
+    this.signedAt,
+    this.fileSize,
+  });
+}
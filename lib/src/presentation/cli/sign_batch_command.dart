@@ -0,0 +1,179 @@
+import 'dart:async';
+import 'dart:io';
+
+import 'package:firmador/src/data/services/sign_stream_client.dart';
+
+/// `firmador-sign-batch <dir> [options]`
+///
+/// Signs every PDF in a directory through the backend, with as many requests
+/// in flight as there are cores, and reports progress and a summary on
+/// stdout. It imports no Flutter library: bin/firmador_sign_batch.dart is
+/// compiled with `dart compile exe` into a standalone binary that needs no
+/// engine, window or display.
+class SignBatchCommand {
+  static const String _directory = 'directory';
+
+  static const int exitOk = 0;
+  static const int exitFailures = 1;
+  static const int exitUsage = 2;
+
+  static const String _passwordEnv = 'FIRMADOR_P12_PASSWORD';
+
+  static const String usage = '''
+Uso: firmador-sign-batch <directorio> --certificate <archivo.p12>
+                          --signer-name <nombre> --signer-id <cédula/RUC> [opciones]
+
+Opciones:
+  --output <dir>        Directorio de salida (por defecto <directorio>/firmados)
+  --location <texto>    Ubicación (por defecto Ecuador)
+  --reason <texto>      Razón (por defecto Firma digital)
+  --page <n>            Página de la firma (por defecto 1)
+  --x <pt> --y <pt>     Posición de la firma (por defecto 100, 100)
+  --timestamp           Incluir sello de tiempo
+  --tsa <url>           Servidor TSA (por defecto https://freetsa.org/tsr)
+  --backend <url>       URL del backend (por defecto http://localhost:8080)
+  --jobs <n>            Firmas simultáneas (por defecto, número de núcleos)
+
+La contraseña del certificado se lee de la variable $_passwordEnv.''';
+
+  /// Runs the batch and returns the process exit code.
+  static Future<int> run(List<String> args) async {
+    final Map<String, String> options;
+    try {
+      options = _parse(args);
+    } on FormatException catch (e) {
+      stderr.writeln(e.message);
+      stderr.writeln(usage);
+      return exitUsage;
+    }
+
+    final password = Platform.environment[_passwordEnv];
+    if (password == null || password.isEmpty) {
+      stderr.writeln('Defina la contraseña del certificado en $_passwordEnv.');
+      return exitUsage;
+    }
+
+    final inputDir = Directory(options[_directory]!);
+    final certificateFile = File(options['--certificate']!);
+    if (!await inputDir.exists() || !await certificateFile.exists()) {
+      stderr.writeln('No existe el directorio o el certificado indicado.');
+      return exitUsage;
+    }
+    final outputDir = Directory(options['--output'] ?? '${inputDir.path}/firmados');
+    await outputDir.create(recursive: true);
+
+    final documents = await inputDir
+        .list()
+        .where((entity) =>
+            entity is File && entity.path.toLowerCase().endsWith('.pdf'))
+        .cast<File>()
+        .toList()
+      ..sort((a, b) => a.path.compareTo(b.path));
+    if (documents.isEmpty) {
+      stdout.writeln('No hay documentos PDF en ${inputDir.path}.');
+      return exitOk;
+    }
+
+    final jobs = int.tryParse(options['--jobs'] ?? '') ?? Platform.numberOfProcessors;
+    final service =
+        SignStreamClient.connect(options['--backend'] ?? 'http://localhost:8080');
+    if (!await service.checkHealth()) {
+      stderr.writeln('El backend no responde en ${options['--backend'] ?? 'http://localhost:8080'}.');
+      return exitFailures;
+    }
+
+    stdout.writeln('Firmando ${documents.length} documentos con $jobs trabajos simultáneos...');
+    final batchWatch = Stopwatch()..start();
+    final failures = <String, String>{};
+    var next = 0;
+    var completed = 0;
+
+    Future<void> worker() async {
+      while (next < documents.length) {
+        final document = documents[next++];
+        final name = document.path.split('/').last;
+        final watch = Stopwatch()..start();
+        final result = await service.sign(
+          documentFile: document,
+          certificateFile: certificateFile,
+          signerName: options['--signer-name']!,
+          signerId: options['--signer-id']!,
+          location: options['--location'] ?? 'Ecuador',
+          reason: options['--reason'] ?? 'Firma digital',
+          certificatePassword: password,
+          signatureX: double.tryParse(options['--x'] ?? '') ?? 100.0,
+          signatureY: double.tryParse(options['--y'] ?? '') ?? 100.0,
+          signaturePage: int.tryParse(options['--page'] ?? '') ?? 1,
+          enableTimestamp: options.containsKey('--timestamp'),
+          timestampServerUrl: options['--tsa'] ?? 'https://freetsa.org/tsr',
+          outputDirectory: outputDir,
+        );
+        completed++;
+        final progress = '[$completed/${documents.length}]';
+        if (result.success) {
+          stdout.writeln('$progress OK     $name -> ${result.filename} (${watch.elapsedMilliseconds} ms)');
+        } else {
+          failures[name] = result.message;
+          stdout.writeln('$progress ERROR  $name: ${result.message}');
+        }
+      }
+    }
+
+    await Future.wait(List.generate(jobs.clamp(1, documents.length), (_) => worker()));
+
+    final seconds = (batchWatch.elapsedMilliseconds / 1000).toStringAsFixed(1);
+    stdout.writeln('');
+    stdout.writeln('Resumen: ${documents.length - failures.length}/${documents.length} '
+        'documentos firmados en $seconds s, ${failures.length} con error.');
+    stdout.writeln('Salida: ${outputDir.path}');
+    for (final entry in failures.entries) {
+      stdout.writeln('  ${entry.key}: ${entry.value}');
+    }
+    await stdout.flush();
+    return failures.isEmpty ? exitOk : exitFailures;
+  }
+
+  static Map<String, String> _parse(List<String> args) {
+    const switches = {'--timestamp'};
+    const valued = {
+      '--certificate',
+      '--signer-name',
+      '--signer-id',
+      '--output',
+      '--location',
+      '--reason',
+      '--page',
+      '--x',
+      '--y',
+      '--tsa',
+      '--backend',
+      '--jobs',
+    };
+
+    final options = <String, String>{};
+    for (var i = 0; i < args.length; i++) {
+      final arg = args[i];
+      if (switches.contains(arg)) {
+        options[arg] = 'true';
+      } else if (valued.contains(arg)) {
+        if (i + 1 >= args.length) {
+          throw FormatException('Falta el valor de $arg.');
+        }
+        options[arg] = args[++i];
+      } else if (!arg.startsWith('--') && !options.containsKey(_directory)) {
+        options[_directory] = arg;
+      } else {
+        throw FormatException('Opción desconocida: $arg');
+      }
+    }
+    if (!options.containsKey(_directory)) {
+      throw const FormatException('Falta el directorio de documentos.');
+    }
+    for (final required in ['--certificate', '--signer-name', '--signer-id']) {
+      if (!options.containsKey(required)) {
+        throw FormatException('Falta la opción $required.');
+      }
+    }
+    return options;
+  }
+}
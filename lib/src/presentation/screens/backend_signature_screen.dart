@@ -2,6 +2,7 @@ import 'dart:async';
 import 'dart:io';
 import 'package:file_picker/file_picker.dart';
 import 'package:firmador/src/data/services/backend_signature_service.dart';
+import 'package:firmador/src/data/services/certificate_keyring_cache.dart';
 import 'package:firmador/src/data/services/user_preferences_service.dart';
 import 'package:dio/dio.dart';
 import 'package:firmador/src/domain/entities/certificate_info.dart';
@@ -1127,12 +1128,34 @@ class _BackendSignatureScreenState extends ConsumerState<BackendSignatureScreen>
     });
 
     try {
-      final backendService = BackendSignatureService();
-      final result = await backendService.getCertificateInfo(
-        certificateFile: _selectedCertificate!,
-        password: _passwordController.text,
+      // A recent unlock of the same .p12 and password skips the PBKDF round trip
+      final cached = await CertificateKeyringCache.lookup(
+        _selectedCertificate!,
+        _passwordController.text,
       );
 
+      final CertificateInfoResult result;
+      if (cached != null) {
+        result = CertificateInfoResult(
+          success: true,
+          message: 'Certificado validado (caché del llavero)',
+          certificateInfo: cached,
+        );
+      } else {
+        final backendService = BackendSignatureService();
+        result = await backendService.getCertificateInfo(
+          certificateFile: _selectedCertificate!,
+          password: _passwordController.text,
+        );
+        if (result.success && result.certificateInfo != null) {
+          await CertificateKeyringCache.store(
+            _selectedCertificate!,
+            _passwordController.text,
+            result.certificateInfo!,
+          );
+        }
+      }
+
       setState(() {
         _isValidatingCertificate = false;
         _isCertificateValid = result.success;
@@ -1254,7 +1277,7 @@ class _BackendSignatureScreenState extends ConsumerState<BackendSignatureScreen>
       debugPrint('PDF position: ${pdfPosition.toString()}');
 
       final backendService = BackendSignatureService();
-      final result = await backendService.signDocument(
+      final result = await backendService.signDocumentStream(
         documentFile: _selectedDocument!,
         certificateFile: _selectedCertificate!,
         signerName: _certificateInfo?.commonName ?? 'Firmante',
@@ -9,6 +9,7 @@ list(APPEND FLUTTER_PLUGIN_LIST
 )
 
 list(APPEND FLUTTER_FFI_PLUGIN_LIST
+  firmador_native
 )
 
 set(PLUGIN_BUNDLED_LIBRARIES)
@@ -0,0 +1,98 @@
+// Compares handing a buffer to native code through dart:ffi with the
+// serialization a MethodChannel performs for the same call.
+//
+// Build the library and run on a Linux host:
+//
+//   cmake -S src -B build && cmake --build build
+//   LD_LIBRARY_PATH=build flutter test benchmark/transport_benchmark_test.dart
+//
+// The channel column measures the StandardMethodCodec encode/decode of the
+// request on both sides plus the native digest; the platform-thread hop of a
+// real channel comes on top of it and is only measurable on a device
+// (macOS/Android) running the app.
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:firmador_native/firmador_native.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+const List<int> _sizes = [
+  1 << 10,
+  64 << 10,
+  1 << 20,
+  16 << 20,
+  100 << 20,
+];
+
+const StandardMethodCodec _codec = StandardMethodCodec();
+
+void main() {
+  test('sha256 transport: ffi vs method channel codec', () async {
+    print('size        ffi (ptr)   ffi (copy)  ffi (async) channel');
+    for (final size in _sizes) {
+      final bytes = Uint8List(size);
+      for (var i = 0; i < size; i++) {
+        bytes[i] = i & 0xff;
+      }
+      final native = malloc<Uint8>(size);
+      native.asTypedList(size).setAll(0, bytes);
+      final iterations = size >= 16 << 20 ? 5 : 50;
+
+      try {
+        final pointer = _median(iterations, () => sha256Pointer(native, size));
+        final copy = _median(iterations, () => sha256Bytes(bytes));
+        final async = await _medianAsync(
+            iterations, () => sha256PointerAsync(native, size));
+        final channel = _median(iterations, () {
+          // Request: Dart encodes, the platform side decodes the bytes
+          final call = _codec.decodeMethodCall(
+              _codec.encodeMethodCall(MethodCall('sha256', bytes)));
+          final digest = sha256Bytes(call.arguments as Uint8List);
+          // Reply: the platform side encodes, Dart decodes the digest
+          return _codec.decodeEnvelope(_codec.encodeSuccessEnvelope(digest));
+        });
+
+        expect(sha256Pointer(native, size), sha256Bytes(bytes));
+        print('${_label(size).padRight(12)}'
+            '${_micros(pointer).padRight(12)}'
+            '${_micros(copy).padRight(12)}'
+            '${_micros(async).padRight(12)}'
+            '${_micros(channel)}');
+      } finally {
+        malloc.free(native);
+      }
+    }
+  }, timeout: Timeout.none);
+}
+
+Duration _median(int iterations, Object? Function() body) {
+  body();
+  final samples = <Duration>[];
+  for (var i = 0; i < iterations; i++) {
+    final watch = Stopwatch()..start();
+    body();
+    samples.add(watch.elapsed);
+  }
+  samples.sort();
+  return samples[samples.length ~/ 2];
+}
+
+Future<Duration> _medianAsync(
+    int iterations, Future<Object?> Function() body) async {
+  await body();
+  final samples = <Duration>[];
+  for (var i = 0; i < iterations; i++) {
+    final watch = Stopwatch()..start();
+    await body();
+    samples.add(watch.elapsed);
+  }
+  samples.sort();
+  return samples[samples.length ~/ 2];
+}
+
+String _label(int size) =>
+    size >= 1 << 20 ? '${size >> 20} MB' : '${size >> 10} KB';
+
+String _micros(Duration duration) => '${duration.inMicroseconds} us';
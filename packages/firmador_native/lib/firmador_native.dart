@@ -0,0 +1,296 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+import 'firmador_native_bindings.dart';
+
+/// Raised when the native engine returns a non-zero status code.
+class FirmadorNativeException implements Exception {
+  final int status;
+  final String message;
+
+  const FirmadorNativeException(this.status, this.message);
+
+  @override
+  String toString() => 'FirmadorNativeException($status): $message';
+}
+
+/// Certificate metadata decoded natively from a PKCS#12 file.
+class NativeCertificateInfo {
+  final String subject;
+  final String issuer;
+  final String commonName;
+  final String serialNumber;
+  final DateTime validFrom;
+  final DateTime validTo;
+
+  const NativeCertificateInfo({
+    required this.subject,
+    required this.issuer,
+    required this.commonName,
+    required this.serialNumber,
+    required this.validFrom,
+    required this.validTo,
+  });
+}
+
+/// SHA-256 of [length] bytes already living in native memory at [data].
+///
+/// Runs synchronously on the calling isolate and never copies the input,
+/// so it is meant for buffers the caller allocated with `malloc` (or that
+/// came from another native API). Prefer [sha256PointerAsync] for large
+/// buffers on the UI isolate.
+Uint8List sha256Pointer(Pointer<Uint8> data, int length) {
+  final digest = malloc<Uint8>(FIRMADOR_SHA256_LENGTH);
+  try {
+    _check(_bindings.firmador_sha256(data, length, digest));
+    return Uint8List.fromList(digest.asTypedList(FIRMADOR_SHA256_LENGTH));
+  } finally {
+    malloc.free(digest);
+  }
+}
+
+/// SHA-256 of a small Dart buffer such as a salted secret.
+///
+/// The bytes are copied to native memory, which is zeroed before it is freed.
+Uint8List sha256Bytes(Uint8List data) {
+  final buffer = malloc<Uint8>(data.isEmpty ? 1 : data.length);
+  try {
+    buffer.asTypedList(data.length).setAll(0, data);
+    return sha256Pointer(buffer, data.length);
+  } finally {
+    buffer.asTypedList(data.length).fillRange(0, data.length, 0);
+    malloc.free(buffer);
+  }
+}
+
+/// Same as [sha256Pointer], executed on the helper isolate.
+///
+/// Only the address crosses the isolate boundary; [data] must stay alive
+/// until the returned future completes.
+Future<Uint8List> sha256PointerAsync(Pointer<Uint8> data, int length) {
+  return _send((id) => _Sha256PointerRequest(id, data.address, length));
+}
+
+/// SHA-256 of the file at [path]. The file is streamed natively and its
+/// contents never enter the Dart heap.
+Future<Uint8List> sha256File(String path) {
+  return _send((id) => _Sha256FileRequest(id, path));
+}
+
+/// Decodes the leaf certificate of the PKCS#12 file at [p12Path].
+Future<NativeCertificateInfo> certificateInfo(String p12Path, String password) {
+  return _send((id) => _CertificateInfoRequest(id, p12Path, password));
+}
+
+/// Signs a SHA-256 [digest] with the private key stored in [p12Path].
+///
+/// Returns a PKCS#1 v1.5 signature for RSA keys or a DER-encoded ECDSA
+/// signature for EC keys.
+Future<Uint8List> signDigest(
+    String p12Path, String password, Uint8List digest) {
+  return _send((id) => _SignDigestRequest(id, p12Path, password, digest));
+}
+
+const String _libName = 'firmador_native';
+
+/// The dynamic library in which the symbols for [FirmadorNativeBindings] can be found.
+final DynamicLibrary _dylib = () {
+  return DynamicLibrary.open('lib$_libName.so');
+}();
+
+/// The bindings to the native functions in [_dylib].
+final FirmadorNativeBindings _bindings = FirmadorNativeBindings(_dylib);
+
+void _check(int status) {
+  if (status == FIRMADOR_OK) {
+    return;
+  }
+  throw FirmadorNativeException(status, switch (status) {
+    FIRMADOR_ERROR_INVALID_ARGUMENT => 'Argumento inválido',
+    FIRMADOR_ERROR_IO => 'No se pudo leer el archivo',
+    FIRMADOR_ERROR_BAD_PASSWORD => 'Contraseña incorrecta.',
+    FIRMADOR_ERROR_BAD_CERTIFICATE => 'El archivo no es un certificado PKCS#12 válido',
+    FIRMADOR_ERROR_BUFFER_TOO_SMALL => 'Búfer de firma insuficiente',
+    _ => 'Error criptográfico nativo',
+  });
+}
+
+String _readCString(Array<Char> chars, int capacity) {
+  final bytes = <int>[];
+  for (var i = 0; i < capacity && chars[i] != 0; i++) {
+    bytes.add(chars[i] & 0xff);
+  }
+  return utf8.decode(bytes, allowMalformed: true);
+}
+
+Uint8List _sha256File(String path) {
+  return using((arena) {
+    final digest = arena<Uint8>(FIRMADOR_SHA256_LENGTH);
+    _check(_bindings.firmador_sha256_file(
+        path.toNativeUtf8(allocator: arena).cast(), digest));
+    return Uint8List.fromList(digest.asTypedList(FIRMADOR_SHA256_LENGTH));
+  });
+}
+
+NativeCertificateInfo _certificateInfo(String p12Path, String password) {
+  return using((arena) {
+    final info = arena<firmador_certificate_info>();
+    _check(_bindings.firmador_p12_certificate_info(
+      p12Path.toNativeUtf8(allocator: arena).cast(),
+      password.toNativeUtf8(allocator: arena).cast(),
+      info,
+    ));
+    final ref = info.ref;
+    return NativeCertificateInfo(
+      subject: _readCString(ref.subject, 512),
+      issuer: _readCString(ref.issuer, 512),
+      commonName: _readCString(ref.common_name, 256),
+      serialNumber: _readCString(ref.serial_number, 128),
+      validFrom: DateTime.fromMillisecondsSinceEpoch(ref.valid_from, isUtc: true),
+      validTo: DateTime.fromMillisecondsSinceEpoch(ref.valid_to, isUtc: true),
+    );
+  });
+}
+
+Uint8List _signDigest(String p12Path, String password, Uint8List digest) {
+  return using((arena) {
+    final nativeDigest = arena<Uint8>(digest.length);
+    nativeDigest.asTypedList(digest.length).setAll(0, digest);
+    // Large enough for RSA-8192 and any ECDSA curve.
+    const capacity = 1024;
+    final signature = arena<Uint8>(capacity);
+    final signatureLength = arena<Size>()..value = capacity;
+    _check(_bindings.firmador_p12_sign_digest(
+      p12Path.toNativeUtf8(allocator: arena).cast(),
+      password.toNativeUtf8(allocator: arena).cast(),
+      nativeDigest,
+      digest.length,
+      signature,
+      signatureLength,
+    ));
+    return Uint8List.fromList(signature.asTypedList(signatureLength.value));
+  });
+}
+
+// Native calls can take hundreds of milliseconds (PKCS#12 key derivation,
+// hashing large files), so they run on a long-lived helper isolate and the
+// results are posted back through its port without involving the platform
+// thread.
+
+sealed class _Request {
+  final int id;
+
+  const _Request(this.id);
+}
+
+class _Sha256PointerRequest extends _Request {
+  final int address;
+  final int length;
+
+  const _Sha256PointerRequest(super.id, this.address, this.length);
+}
+
+class _Sha256FileRequest extends _Request {
+  final String path;
+
+  const _Sha256FileRequest(super.id, this.path);
+}
+
+class _CertificateInfoRequest extends _Request {
+  final String p12Path;
+  final String password;
+
+  const _CertificateInfoRequest(super.id, this.p12Path, this.password);
+}
+
+class _SignDigestRequest extends _Request {
+  final String p12Path;
+  final String password;
+  final Uint8List digest;
+
+  const _SignDigestRequest(super.id, this.p12Path, this.password, this.digest);
+}
+
+class _Response {
+  final int id;
+  final Object? result;
+  // A FirmadorNativeException, or a RemoteError for anything else thrown on
+  // the helper isolate, so the caller's future always completes.
+  final Object? error;
+
+  const _Response(this.id, this.result, this.error);
+}
+
+int _nextRequestId = 0;
+
+final Map<int, Completer<Object?>> _requests = <int, Completer<Object?>>{};
+
+Future<T> _send<T>(_Request Function(int id) build) async {
+  final helperIsolateSendPort = await _helperIsolateSendPort;
+  final request = build(_nextRequestId++);
+  final completer = Completer<Object?>();
+  _requests[request.id] = completer;
+  helperIsolateSendPort.send(request);
+  return (await completer.future) as T;
+}
+
+Object? _handle(_Request request) {
+  return switch (request) {
+    _Sha256PointerRequest(:final address, :final length) =>
+      sha256Pointer(Pointer<Uint8>.fromAddress(address), length),
+    _Sha256FileRequest(:final path) => _sha256File(path),
+    _CertificateInfoRequest(:final p12Path, :final password) =>
+      _certificateInfo(p12Path, password),
+    _SignDigestRequest(:final p12Path, :final password, :final digest) =>
+      _signDigest(p12Path, password, digest),
+  };
+}
+
+Future<SendPort> _helperIsolateSendPort = () async {
+  final completer = Completer<SendPort>();
+
+  final receivePort = ReceivePort()
+    ..listen((dynamic data) {
+      if (data is SendPort) {
+        completer.complete(data);
+        return;
+      }
+      if (data is _Response) {
+        final request = _requests.remove(data.id)!;
+        if (data.error != null) {
+          request.completeError(data.error!);
+        } else {
+          request.complete(data.result);
+        }
+        return;
+      }
+      throw UnsupportedError('Unsupported message type: ${data.runtimeType}');
+    });
+
+  await Isolate.spawn((SendPort sendPort) async {
+    final helperReceivePort = ReceivePort()
+      ..listen((dynamic data) {
+        if (data is _Request) {
+          try {
+            sendPort.send(_Response(data.id, _handle(data), null));
+          } on FirmadorNativeException catch (e) {
+            sendPort.send(_Response(data.id, null, e));
+          } catch (e, stackTrace) {
+            sendPort.send(
+                _Response(data.id, null, RemoteError('$e', '$stackTrace')));
+          }
+          return;
+        }
+        throw UnsupportedError('Unsupported message type: ${data.runtimeType}');
+      });
+
+    sendPort.send(helperReceivePort.sendPort);
+  }, receivePort.sendPort);
+
+  return completer.future;
+}();
@@ -0,0 +1,132 @@
+// ignore_for_file: always_specify_types
+// ignore_for_file: camel_case_types
+// ignore_for_file: non_constant_identifier_names
+
+// Hand-written bindings for `src/firmador_native.h`, laid out the way
+// package:ffigen emits them. Keep this file in sync with the header.
+import 'dart:ffi' as ffi;
+
+/// Bindings for the `firmador_native` shared library.
+class FirmadorNativeBindings {
+  /// Holds the symbol lookup function.
+  final ffi.Pointer<T> Function<T extends ffi.NativeType>(String symbolName)
+      _lookup;
+
+  /// The symbols are looked up in [dynamicLibrary].
+  FirmadorNativeBindings(ffi.DynamicLibrary dynamicLibrary)
+      : _lookup = dynamicLibrary.lookup;
+
+  int firmador_sha256(
+    ffi.Pointer<ffi.Uint8> data,
+    int length,
+    ffi.Pointer<ffi.Uint8> out_digest,
+  ) {
+    return _firmador_sha256(data, length, out_digest);
+  }
+
+  late final _firmador_sha256Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ffi.Uint8>, ffi.Size,
+              ffi.Pointer<ffi.Uint8>)>>('firmador_sha256');
+  late final _firmador_sha256 = _firmador_sha256Ptr.asFunction<
+      int Function(ffi.Pointer<ffi.Uint8>, int, ffi.Pointer<ffi.Uint8>)>();
+
+  int firmador_sha256_file(
+    ffi.Pointer<ffi.Char> path,
+    ffi.Pointer<ffi.Uint8> out_digest,
+  ) {
+    return _firmador_sha256_file(path, out_digest);
+  }
+
+  late final _firmador_sha256_filePtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ffi.Char>,
+              ffi.Pointer<ffi.Uint8>)>>('firmador_sha256_file');
+  late final _firmador_sha256_file = _firmador_sha256_filePtr.asFunction<
+      int Function(ffi.Pointer<ffi.Char>, ffi.Pointer<ffi.Uint8>)>();
+
+  int firmador_p12_certificate_info(
+    ffi.Pointer<ffi.Char> p12_path,
+    ffi.Pointer<ffi.Char> password,
+    ffi.Pointer<firmador_certificate_info> out_info,
+  ) {
+    return _firmador_p12_certificate_info(p12_path, password, out_info);
+  }
+
+  late final _firmador_p12_certificate_infoPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ffi.Char>, ffi.Pointer<ffi.Char>,
+              ffi.Pointer<firmador_certificate_info>)>>(
+      'firmador_p12_certificate_info');
+  late final _firmador_p12_certificate_info =
+      _firmador_p12_certificate_infoPtr.asFunction<
+          int Function(ffi.Pointer<ffi.Char>, ffi.Pointer<ffi.Char>,
+              ffi.Pointer<firmador_certificate_info>)>();
+
+  int firmador_p12_sign_digest(
+    ffi.Pointer<ffi.Char> p12_path,
+    ffi.Pointer<ffi.Char> password,
+    ffi.Pointer<ffi.Uint8> digest,
+    int digest_length,
+    ffi.Pointer<ffi.Uint8> out_signature,
+    ffi.Pointer<ffi.Size> signature_length,
+  ) {
+    return _firmador_p12_sign_digest(p12_path, password, digest,
+        digest_length, out_signature, signature_length);
+  }
+
+  late final _firmador_p12_sign_digestPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(
+              ffi.Pointer<ffi.Char>,
+              ffi.Pointer<ffi.Char>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Size,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Size>)>>('firmador_p12_sign_digest');
+  late final _firmador_p12_sign_digest =
+      _firmador_p12_sign_digestPtr.asFunction<
+          int Function(
+              ffi.Pointer<ffi.Char>,
+              ffi.Pointer<ffi.Char>,
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Size>)>();
+}
+
+final class firmador_certificate_info extends ffi.Struct {
+  @ffi.Array.multi([512])
+  external ffi.Array<ffi.Char> subject;
+
+  @ffi.Array.multi([512])
+  external ffi.Array<ffi.Char> issuer;
+
+  @ffi.Array.multi([256])
+  external ffi.Array<ffi.Char> common_name;
+
+  @ffi.Array.multi([128])
+  external ffi.Array<ffi.Char> serial_number;
+
+  @ffi.Int64()
+  external int valid_from;
+
+  @ffi.Int64()
+  external int valid_to;
+}
+
+const int FIRMADOR_SHA256_LENGTH = 32;
+
+const int FIRMADOR_OK = 0;
+
+const int FIRMADOR_ERROR_INVALID_ARGUMENT = 1;
+
+const int FIRMADOR_ERROR_IO = 2;
+
+const int FIRMADOR_ERROR_BAD_PASSWORD = 3;
+
+const int FIRMADOR_ERROR_BAD_CERTIFICATE = 4;
+
+const int FIRMADOR_ERROR_BUFFER_TOO_SMALL = 5;
+
+const int FIRMADOR_ERROR_CRYPTO = 6;
@@ -0,0 +1,216 @@
+#include "firmador_native.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pkcs12.h>
+#include <openssl/x509.h>
+
+#define FILE_CHUNK_SIZE (1 << 20)
+
+int firmador_sha256(const uint8_t* data, size_t length, uint8_t* out_digest) {
+  if ((data == NULL && length > 0) || out_digest == NULL) {
+    return FIRMADOR_ERROR_INVALID_ARGUMENT;
+  }
+  unsigned int digest_length = 0;
+  if (!EVP_Digest(data, length, out_digest, &digest_length, EVP_sha256(),
+                  NULL)) {
+    return FIRMADOR_ERROR_CRYPTO;
+  }
+  return FIRMADOR_OK;
+}
+
+int firmador_sha256_file(const char* path, uint8_t* out_digest) {
+  if (path == NULL || out_digest == NULL) {
+    return FIRMADOR_ERROR_INVALID_ARGUMENT;
+  }
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return FIRMADOR_ERROR_IO;
+  }
+
+  int status = FIRMADOR_OK;
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  unsigned char* chunk = OPENSSL_malloc(FILE_CHUNK_SIZE);
+  if (ctx == NULL || chunk == NULL ||
+      !EVP_DigestInit_ex(ctx, EVP_sha256(), NULL)) {
+    status = FIRMADOR_ERROR_CRYPTO;
+    goto done;
+  }
+
+  size_t read;
+  while ((read = fread(chunk, 1, FILE_CHUNK_SIZE, file)) > 0) {
+    if (!EVP_DigestUpdate(ctx, chunk, read)) {
+      status = FIRMADOR_ERROR_CRYPTO;
+      goto done;
+    }
+  }
+  if (ferror(file)) {
+    status = FIRMADOR_ERROR_IO;
+    goto done;
+  }
+  if (!EVP_DigestFinal_ex(ctx, out_digest, NULL)) {
+    status = FIRMADOR_ERROR_CRYPTO;
+  }
+
+done:
+  OPENSSL_free(chunk);
+  EVP_MD_CTX_free(ctx);
+  fclose(file);
+  return status;
+}
+
+// Parses |p12_path| into its private key and leaf certificate. Either output
+// may be NULL when the caller does not need it.
+static int load_p12(const char* p12_path, const char* password,
+                    EVP_PKEY** out_key, X509** out_certificate) {
+  if (p12_path == NULL || password == NULL) {
+    return FIRMADOR_ERROR_INVALID_ARGUMENT;
+  }
+  BIO* bio = BIO_new_file(p12_path, "rb");
+  if (bio == NULL) {
+    return FIRMADOR_ERROR_IO;
+  }
+  PKCS12* p12 = d2i_PKCS12_bio(bio, NULL);
+  BIO_free(bio);
+  if (p12 == NULL) {
+    ERR_clear_error();
+    return FIRMADOR_ERROR_BAD_CERTIFICATE;
+  }
+
+  int status = FIRMADOR_OK;
+  if (!PKCS12_verify_mac(p12, password, -1)) {
+    status = FIRMADOR_ERROR_BAD_PASSWORD;
+  } else {
+    EVP_PKEY* key = NULL;
+    X509* certificate = NULL;
+    if (!PKCS12_parse(p12, password, &key, &certificate, NULL) ||
+        certificate == NULL) {
+      status = FIRMADOR_ERROR_BAD_CERTIFICATE;
+      EVP_PKEY_free(key);
+      X509_free(certificate);
+    } else {
+      if (out_key != NULL) {
+        *out_key = key;
+      } else {
+        EVP_PKEY_free(key);
+      }
+      if (out_certificate != NULL) {
+        *out_certificate = certificate;
+      } else {
+        X509_free(certificate);
+      }
+    }
+  }
+  PKCS12_free(p12);
+  ERR_clear_error();
+  return status;
+}
+
+static int64_t asn1_time_to_millis(const ASN1_TIME* time) {
+  struct tm tm;
+  if (time == NULL || !ASN1_TIME_to_tm(time, &tm)) {
+    return 0;
+  }
+  int days = 0;
+  int seconds = 0;
+  // Difference from the epoch, computed by OpenSSL to avoid timegm().
+  ASN1_TIME* epoch = ASN1_TIME_set(NULL, 0);
+  int ok = ASN1_TIME_diff(&days, &seconds, epoch, time);
+  ASN1_TIME_free(epoch);
+  if (!ok) {
+    return 0;
+  }
+  return ((int64_t)days * 86400 + seconds) * 1000;
+}
+
+static void copy_name(const X509_NAME* name, char* out, size_t capacity) {
+  out[0] = '\0';
+  BIO* bio = BIO_new(BIO_s_mem());
+  if (bio == NULL) {
+    return;
+  }
+  if (X509_NAME_print_ex(bio, name, 0, XN_FLAG_RFC2253) >= 0) {
+    int length = BIO_read(bio, out, (int)capacity - 1);
+    out[length > 0 ? length : 0] = '\0';
+  }
+  BIO_free(bio);
+}
+
+int firmador_p12_certificate_info(const char* p12_path, const char* password,
+                                  firmador_certificate_info* out_info) {
+  if (out_info == NULL) {
+    return FIRMADOR_ERROR_INVALID_ARGUMENT;
+  }
+  X509* certificate = NULL;
+  int status = load_p12(p12_path, password, NULL, &certificate);
+  if (status != FIRMADOR_OK) {
+    return status;
+  }
+
+  memset(out_info, 0, sizeof(*out_info));
+  copy_name(X509_get_subject_name(certificate), out_info->subject,
+            sizeof(out_info->subject));
+  copy_name(X509_get_issuer_name(certificate), out_info->issuer,
+            sizeof(out_info->issuer));
+  X509_NAME_get_text_by_NID(X509_get_subject_name(certificate),
+                            NID_commonName, out_info->common_name,
+                            sizeof(out_info->common_name));
+
+  BIGNUM* serial = ASN1_INTEGER_to_BN(X509_get0_serialNumber(certificate), NULL);
+  if (serial != NULL) {
+    char* hex = BN_bn2hex(serial);
+    if (hex != NULL) {
+      strncpy(out_info->serial_number, hex,
+              sizeof(out_info->serial_number) - 1);
+      OPENSSL_free(hex);
+    }
+    BN_free(serial);
+  }
+
+  out_info->valid_from = asn1_time_to_millis(X509_get0_notBefore(certificate));
+  out_info->valid_to = asn1_time_to_millis(X509_get0_notAfter(certificate));
+
+  X509_free(certificate);
+  return FIRMADOR_OK;
+}
+
+int firmador_p12_sign_digest(const char* p12_path, const char* password,
+                             const uint8_t* digest, size_t digest_length,
+                             uint8_t* out_signature,
+                             size_t* signature_length) {
+  if (digest == NULL || digest_length != FIRMADOR_SHA256_LENGTH ||
+      out_signature == NULL || signature_length == NULL) {
+    return FIRMADOR_ERROR_INVALID_ARGUMENT;
+  }
+  EVP_PKEY* key = NULL;
+  int status = load_p12(p12_path, password, &key, NULL);
+  if (status != FIRMADOR_OK) {
+    return status;
+  }
+  if (key == NULL) {
+    return FIRMADOR_ERROR_BAD_CERTIFICATE;
+  }
+
+  if ((size_t)EVP_PKEY_size(key) > *signature_length) {
+    *signature_length = (size_t)EVP_PKEY_size(key);
+    EVP_PKEY_free(key);
+    return FIRMADOR_ERROR_BUFFER_TOO_SMALL;
+  }
+
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, NULL);
+  if (ctx == NULL || EVP_PKEY_sign_init(ctx) <= 0 ||
+      EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) <= 0 ||
+      EVP_PKEY_sign(ctx, out_signature, signature_length, digest,
+                    digest_length) <= 0) {
+    status = FIRMADOR_ERROR_CRYPTO;
+  }
+
+  EVP_PKEY_CTX_free(ctx);
+  EVP_PKEY_free(key);
+  ERR_clear_error();
+  return status;
+}
@@ -0,0 +1,68 @@
+#ifndef FIRMADOR_NATIVE_H_
+#define FIRMADOR_NATIVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if _WIN32
+#define FFI_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define FFI_PLUGIN_EXPORT __attribute__((visibility("default"))) __attribute__((used))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIRMADOR_SHA256_LENGTH 32
+
+// Status codes returned by every entry point. Keep in sync with
+// lib/firmador_native_bindings.dart.
+#define FIRMADOR_OK 0
+#define FIRMADOR_ERROR_INVALID_ARGUMENT 1
+#define FIRMADOR_ERROR_IO 2
+#define FIRMADOR_ERROR_BAD_PASSWORD 3
+#define FIRMADOR_ERROR_BAD_CERTIFICATE 4
+#define FIRMADOR_ERROR_BUFFER_TOO_SMALL 5
+#define FIRMADOR_ERROR_CRYPTO 6
+
+typedef struct {
+  char subject[512];
+  char issuer[512];
+  char common_name[256];
+  char serial_number[128];
+  // Milliseconds since the Unix epoch, UTC.
+  int64_t valid_from;
+  int64_t valid_to;
+} firmador_certificate_info;
+
+// Computes the SHA-256 digest of |length| bytes at |data| into |out_digest|,
+// which must hold FIRMADOR_SHA256_LENGTH bytes. The input is read in place.
+FFI_PLUGIN_EXPORT int firmador_sha256(const uint8_t* data, size_t length,
+                                      uint8_t* out_digest);
+
+// Computes the SHA-256 digest of the file at |path| without handing its
+// contents to the caller.
+FFI_PLUGIN_EXPORT int firmador_sha256_file(const char* path,
+                                           uint8_t* out_digest);
+
+// Decodes the leaf certificate of the PKCS#12 file at |p12_path|.
+FFI_PLUGIN_EXPORT int firmador_p12_certificate_info(
+    const char* p12_path, const char* password,
+    firmador_certificate_info* out_info);
+
+// Signs a precomputed SHA-256 |digest| with the private key of the PKCS#12
+// file at |p12_path| (RSA PKCS#1 v1.5 or ECDSA). On input |signature_length|
+// is the capacity of |out_signature|; on success it is the bytes written.
+FFI_PLUGIN_EXPORT int firmador_p12_sign_digest(const char* p12_path,
+                                               const char* password,
+                                               const uint8_t* digest,
+                                               size_t digest_length,
+                                               uint8_t* out_signature,
+                                               size_t* signature_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMADOR_NATIVE_H_
@@ -0,0 +1,84 @@
+#!/bin/bash
+
+# Run several backend instances on this machine sharing one signing queue
+# Usage: ./run-cluster.sh [instances] [base-port]
+echo "🚀 Starting Firmador Backend cluster..."
+
+# Colors
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+print_info() {
+    echo -e "${GREEN}[INFO]${NC} $1"
+}
+
+print_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+print_step() {
+    echo -e "${BLUE}[STEP]${NC} $1"
+}
+
+INSTANCES=${1:-3}
+BASE_PORT=${2:-8080}
+QUEUE_PATH=${FIRMADOR_CLUSTER_QUEUE_PATH:-/tmp/firmador-cluster-queue}
+# Every instance must share the key that encrypts queued requests
+SECRET_KEY=${FIRMADOR_CLUSTER_SECRET_KEY:-$(head -c 32 /dev/urandom | base64)}
+LOG_DIR=${LOG_DIR:-/tmp/firmador-cluster-logs}
+
+if ! command -v java &> /dev/null || ! command -v mvn &> /dev/null; then
+    print_error "Java 17+ and Maven are required"
+    exit 1
+fi
+
+cd backend
+JAR=$(ls target/firmador-backend-*.jar 2>/dev/null | head -n 1)
+if [ -z "$JAR" ]; then
+    print_step "Building backend..."
+    mvn clean package -DskipTests -q || { print_error "Build failed"; exit 1; }
+    JAR=$(ls target/firmador-backend-*.jar | head -n 1)
+fi
+
+mkdir -p "$QUEUE_PATH" "$LOG_DIR"
+PIDS=()
+
+cleanup() {
+    print_step "Stopping ${#PIDS[@]} instances..."
+    kill "${PIDS[@]}" 2>/dev/null
+    wait 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+for i in $(seq 1 "$INSTANCES"); do
+    PORT=$((BASE_PORT + i - 1))
+    print_step "Starting instance $i on port $PORT..."
+    FIRMADOR_CLUSTER_ENABLED=true \
+    FIRMADOR_CLUSTER_QUEUE_PATH="$QUEUE_PATH" \
+    FIRMADOR_CLUSTER_SECRET_KEY="$SECRET_KEY" \
+    FIRMADOR_INSTANCE_ID="instance-$i" \
+        java -jar "$JAR" --server.port="$PORT" > "$LOG_DIR/instance-$i.log" 2>&1 &
+    PIDS+=($!)
+done
+
+for i in $(seq 1 "$INSTANCES"); do
+    PORT=$((BASE_PORT + i - 1))
+    for attempt in {1..60}; do
+        if curl -s "http://localhost:$PORT/api/signature/health" > /dev/null 2>&1; then
+            print_info "✅ Instance $i ready at http://localhost:$PORT"
+            break
+        fi
+        if [ "$attempt" -eq 60 ]; then
+            print_error "Instance $i failed to start, see $LOG_DIR/instance-$i.log"
+            exit 1
+        fi
+        sleep 1
+    done
+done
+
+print_info "Shared queue: $QUEUE_PATH"
+print_info "Submit with -F async=true to /api/signature/sign on any port; poll /api/signature/jobs/{jobId} on any other"
+print_info "Press Ctrl+C to stop all instances"
+wait
@@ -0,0 +1,50 @@
+import 'dart:io';
+
+import 'package:firmador/src/presentation/cli/sign_batch_command.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+void main() {
+  // `dart compile exe` has no dart:ui, so nothing reachable from the CLI
+  // entrypoint may import Flutter or a Flutter plugin.
+  test('batch CLI does not depend on Flutter', () {
+    final forbidden = RegExp(
+        r'''^(import|export) '(dart:ui|package:flutter/|package:flutter_|package:path_provider)''',
+        multiLine: true);
+    final pending = ['bin/firmador_sign_batch.dart'];
+    final visited = <String>{};
+
+    while (pending.isNotEmpty) {
+      final path = pending.removeLast();
+      if (!visited.add(path)) {
+        continue;
+      }
+      final source = File(path).readAsStringSync();
+      expect(forbidden.hasMatch(source), isFalse,
+          reason: '$path imports Flutter');
+      for (final match in RegExp(r'''^(?:import|export) 'package:firmador/([^']+)'''',
+              multiLine: true)
+          .allMatches(source)) {
+        pending.add('lib/${match.group(1)}');
+      }
+    }
+
+    expect(visited, contains('lib/src/data/services/sign_stream_client.dart'));
+  });
+
+  test('rejects missing directory and options as usage errors', () async {
+    expect(await SignBatchCommand.run([]), SignBatchCommand.exitUsage);
+    expect(await SignBatchCommand.run(['./contratos']), SignBatchCommand.exitUsage);
+    expect(
+        await SignBatchCommand.run([
+          './contratos',
+          '--certificate',
+          'certificado.p12',
+          '--signer-name',
+          'Juan Pérez',
+          '--signer-id',
+          '1234567890',
+          '--unknown',
+        ]),
+        SignBatchCommand.exitUsage);
+  });
+}